@@ -0,0 +1,84 @@
+/*!
+	\file
+	\brief	Epoch time helpers used by FF_A6lib
+	\author	Flying Domotic
+	\date	October 17th, 2026
+*/
+
+#include <FF_A6clock.h>
+
+/*!
+
+	\brief	Convert a date and time into epoch
+
+	\param[in]	year: year (1970 and after)
+	\param[in]	month: month (1-12)
+	\param[in]	day: day of month (1-31)
+	\param[in]	hour: hour (0-23)
+	\param[in]	minute: minute (0-59)
+	\param[in]	second: second (0-59)
+	\return	Count of seconds since 01/01/1970 00:00:00
+
+*/
+uint32_t FF_A6clock::toEpoch(const uint16_t year, const uint8_t month, const uint8_t day, const uint8_t hour, const uint8_t minute, const uint8_t second) {
+	// Count days from 1970, with years starting in March, so that leap day is last day of year
+	uint16_t y = (month <= 2) ? year - 1 : year;
+	uint16_t m = (month <= 2) ? month + 9 : month - 3;
+	uint32_t days = 365UL * y + y / 4 - y / 100 + y / 400 + (153 * m + 2) / 5 + day - 1 - 719468UL;
+	return days * 86400UL + hour * 3600UL + minute * 60UL + second;
+}
+
+/*!
+
+	\brief	Parse a modem time ("yy/MM/dd,hh:mm:ss", optionally followed by time zone, as given by AT+CCLK?)
+
+	\param[in]	text: text to parse (may start with quote)
+	\param[out]	epoch: parsed time (local time)
+	\param[out]	timeZone: time zone (minutes east of UTC, 0 if not given)
+	\return	true if time is valid, false else (including modem clock not set)
+
+*/
+bool FF_A6clock::parseModemTime(const char* text, uint32_t& epoch, int16_t& timeZone) {
+	int values[7];
+	char sign = '+';
+	if (*text == '"') text++;
+	int count = sscanf(text, "%d/%d/%d,%d:%d:%d%c%d", &values[0], &values[1], &values[2], &values[3], &values[4], &values[5], &sign, &values[6]);
+	if (count < 6) {
+		return false;
+	}
+	// Modem clock not set by network usually starts in 2000 or 2004
+	if (values[0] < 20 || values[1] < 1 || values[1] > 12 || values[2] < 1 || values[2] > 31
+			|| values[3] > 23 || values[4] > 59 || values[5] > 59) {
+		return false;
+	}
+	epoch = toEpoch(2000 + values[0], values[1], values[2], values[3], values[4], values[5]);
+	timeZone = (count == 8) ? ((sign == '-') ? -15 : 15) * values[6] : 0;	// Time zone is given in quarters of hour
+	return true;
+}
+
+/*!
+
+	\brief	Format an epoch as "dd/mm/yyyy hh:mm:ss"
+
+	\param[in]	epoch: count of seconds since 01/01/1970
+	\param[out]	buffer: buffer to write date into (at least A6_DATE_LEN)
+	\param[in]	bufferSize: size of buffer
+	\return	none
+
+*/
+void FF_A6clock::format(const uint32_t epoch, char* buffer, const size_t bufferSize) {
+	uint32_t days = epoch / 86400UL;
+	uint32_t seconds = epoch % 86400UL;
+	// Reverse of toEpoch computation (years starting in March)
+	uint32_t z = days + 719468UL;
+	uint32_t era = z / 146097UL;
+	uint32_t dayOfEra = z - era * 146097UL;
+	uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+	uint32_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+	uint32_t m = (5 * dayOfYear + 2) / 153;
+	uint8_t day = dayOfYear - (153 * m + 2) / 5 + 1;
+	uint8_t month = (m < 10) ? m + 3 : m - 9;
+	uint16_t year = yearOfEra + era * 400 + (month <= 2);
+	snprintf_P(buffer, bufferSize, PSTR("%02d/%02d/%04d %02d:%02d:%02d"), day, month, year,
+		(int) (seconds / 3600), (int) ((seconds / 60) % 60), (int) (seconds % 60));
+}
@@ -0,0 +1,33 @@
+/*!
+	\file
+	\brief	Epoch time helpers used by FF_A6lib
+	\author	Flying Domotic
+	\date	October 17th, 2026
+
+	Have a look at FF_A6clock.cpp for details
+
+*/
+
+#ifndef FF_A6clock_h
+#define FF_A6clock_h
+
+#include <Arduino.h>
+
+// Constants
+#define A6_DATE_LEN 20										//!< Length of a formatted date ("dd/mm/yyyy hh:mm:ss", including final zero)
+
+class FF_A6clock {
+public:
+	/*!	\class FF_A6clock
+		\brief Epoch time helpers used by FF_A6lib
+
+		Times are kept as 32 bits count of seconds since 01/01/1970, in local time (as given by modem or time source),
+			and only formatted when displayed.
+	*/
+
+	// Public routines (documented in FF_A6clock.cpp)
+	static uint32_t toEpoch(const uint16_t year, const uint8_t month, const uint8_t day, const uint8_t hour, const uint8_t minute, const uint8_t second);
+	static bool parseModemTime(const char* text, uint32_t& epoch, int16_t& timeZone);
+	static void format(const uint32_t epoch, char* buffer, const size_t bufferSize);
+};
+#endif
@@ -0,0 +1,193 @@
+/*!
+	\file
+	\brief	Static dictionary compressor for short machine generated messages
+	\author	Flying Domotic
+	\date	October 17th, 2026
+*/
+
+#include <FF_A6compress.h>
+
+// Built-in dictionary, tuned for key=value telemetry (words separated by zeros, ending with an empty word)
+static const char builtinDictionary[] PROGMEM =
+	"temperature=\0" "humidity=\0" "pressure=\0" "battery=\0" "voltage=\0" "current=\0" "power=\0" "energy=\0"
+	"status=\0" "alarm=\0" "error=\0" "uptime=\0" "rssi=\0" "signal=\0" "level=\0" "count=\0"
+	"time=\0" "date=\0" "min=\0" "max=\0" "avg=\0" "total=\0" "value=\0" "state=\0"
+	"mode=\0" "temp=\0" "hum=\0" "bat=\0" "relay\0" "sensor\0" "door\0" "window\0"
+	"water\0" "flow\0" "rain\0" "wind\0" "speed\0" "heat\0" "pump\0" "boiler\0"
+	"tank\0" "solar\0" "grid\0" "load\0" "light\0" "motion\0" "alert\0" "reboot\0"
+	"restart\0" "online\0" "offline\0" "open\0" "closed\0" "true\0" "false\0" "high\0"
+	"low\0" "OK\0" "ON\0" "OFF\0" ", \0" "; \0" "=0\0" "=1\0"
+	"00\0" "000\0";
+
+const char* FF_A6compress::dictionary = builtinDictionary;
+uint8_t FF_A6compress::dictionaryId = A6_COMPRESS_BUILTIN_DICTIONARY;
+
+/*!
+
+	\brief	Set dictionary used to compress and decompress messages
+
+	\param[in]	words: packed dictionary (up to A6_COMPRESS_MAX_WORDS words separated by zeros, ending with an empty word), may be in PROGMEM
+	\param[in]	id: dictionary identifier (put in compressed data, should not be A6_COMPRESS_BUILTIN_DICTIONARY)
+	\return	none
+
+*/
+void FF_A6compress::setDictionary(const char* words, const uint8_t id) {
+	dictionary = words;
+	dictionaryId = id;
+}
+
+/*!
+
+	\brief	Compress a message
+
+	At each position, a run of digits is packed if long enough, else the longest dictionary word is used, else character is copied.
+
+	\param[in]	text: message to compress
+	\param[in]	len: message length (bytes)
+	\param[out]	out: buffer to write compressed data into
+	\param[in]	outSize: size of output buffer
+	\return	Length of compressed data (0 if buffer is too small)
+
+*/
+uint16_t FF_A6compress::compress(const char* text, const uint16_t len, uint8_t* out, const uint16_t outSize) {
+	uint16_t outLen = 0;
+	if (outSize < 1) return 0;
+	out[outLen++] = dictionaryId;
+	uint16_t pos = 0;
+	while (pos < len) {
+		// Look for a run of digits
+		uint16_t run = 0;
+		while (pos + run < len && run < 255 && digitCode(text[pos + run]) != 0xff) {
+			run++;
+		}
+		if (run >= A6_COMPRESS_MIN_DIGITS) {
+			if (outLen + 2 + (run + 1) / 2 > outSize) return 0;
+			out[outLen++] = A6_COMPRESS_DIGITS;
+			out[outLen++] = run;
+			for (uint16_t i = 0; i < run; i += 2) {
+				uint8_t high = digitCode(text[pos + i]);
+				uint8_t low = (i + 1 < run) ? digitCode(text[pos + i + 1]) : 0x0f;
+				out[outLen++] = (high << 4) | low;
+			}
+			pos += run;
+			continue;
+		}
+		// Look for longest dictionary word
+		uint8_t bestIndex = 0;
+		uint8_t bestLen = 1;								// Words of one character are useless
+		const char* ptr = dictionary;						// Walk dictionary once
+		for (uint8_t i = 0; i < A6_COMPRESS_MAX_WORDS; i++) {
+			uint8_t wordLen = strlen_P(ptr);
+			if (!wordLen) break;							// End of dictionary
+			if (wordLen > bestLen && wordLen <= len - pos && (char) pgm_read_byte(ptr) == text[pos]
+					&& !memcmp_P(text + pos, ptr, wordLen)) {
+				bestIndex = i;
+				bestLen = wordLen;
+			}
+			ptr += wordLen + 1;
+		}
+		if (bestLen > 1) {
+			if (outLen + 1 > outSize) return 0;
+			out[outLen++] = A6_COMPRESS_FIRST_WORD + bestIndex;
+			pos += bestLen;
+			continue;
+		}
+		// Copy character
+		uint8_t c = text[pos++];
+		if (c >= 0x80) {
+			if (outLen + 2 > outSize) return 0;
+			out[outLen++] = A6_COMPRESS_ESCAPE;
+		} else if (outLen + 1 > outSize) {
+			return 0;
+		}
+		out[outLen++] = c;
+	}
+	return outLen;
+}
+
+/*!
+
+	\brief	Decompress a message
+
+	\param[in]	in: compressed data
+	\param[in]	len: compressed data length
+	\param[out]	out: buffer to write decompressed message into (zero terminated), NULL to only compute length
+	\param[in]	outSize: size of output buffer
+	\return	Length of decompressed message (0 if data is invalid or buffer is too small)
+
+*/
+uint16_t FF_A6compress::decompress(const uint8_t* in, const uint16_t len, char* out, const uint16_t outSize) {
+	static const char digitChars[] = "0123456789.-";
+	uint16_t outLen = 0;
+	if (!len || in[0] != dictionaryId) return 0;			// Not compressed with our dictionary
+	#define A6_OUTPUT_CHAR(c) {if (out) {if (outLen + 1 >= outSize) return 0; out[outLen] = (c);} outLen++;}
+	for (uint16_t pos = 1; pos < len; pos++) {
+		uint8_t code = in[pos];
+		if (code < 0x80) {									// Literal ASCII character
+			A6_OUTPUT_CHAR(code);
+		} else if (code == A6_COMPRESS_ESCAPE) {			// Literal byte
+			if (++pos >= len) return 0;
+			A6_OUTPUT_CHAR(in[pos]);
+		} else if (code == A6_COMPRESS_DIGITS) {			// Run of digits
+			if (pos + 1 >= len) return 0;
+			uint8_t run = in[++pos];
+			if (pos + (run + 1) / 2 >= len) return 0;
+			for (uint8_t i = 0; i < run; i++) {
+				uint8_t nibble = (i & 1) ? (in[pos + 1 + i / 2] & 0x0f) : (in[pos + 1 + i / 2] >> 4);
+				if (nibble >= sizeof(digitChars) - 1) return 0;
+				A6_OUTPUT_CHAR(digitChars[nibble]);
+			}
+			pos += (run + 1) / 2;
+		} else if (code < A6_COMPRESS_FIRST_WORD + A6_COMPRESS_MAX_WORDS) {	// Dictionary word
+			uint8_t wordLen;
+			const char* ptr = word(code - A6_COMPRESS_FIRST_WORD, wordLen);
+			if (!wordLen) return 0;
+			for (uint8_t i = 0; i < wordLen; i++) {
+				A6_OUTPUT_CHAR((char) pgm_read_byte(ptr + i));
+			}
+		} else {											// Reserved code
+			return 0;
+		}
+	}
+	#undef A6_OUTPUT_CHAR
+	if (out) out[outLen] = 0;
+	return outLen;
+}
+
+/*!
+
+	\brief	[Private] Return a dictionary word
+
+	\param[in]	index: word index
+	\param[out]	wordLen: word length (0 if index is after end of dictionary)
+	\return	Pointer to word (may be in PROGMEM)
+
+*/
+const char* FF_A6compress::word(const uint8_t index, uint8_t& wordLen) {
+	const char* ptr = dictionary;
+	for (uint8_t i = 0; i < index; i++) {
+		uint8_t len = strlen_P(ptr);
+		if (!len) {
+			wordLen = 0;
+			return ptr;
+		}
+		ptr += len + 1;
+	}
+	wordLen = strlen_P(ptr);
+	return ptr;
+}
+
+/*!
+
+	\brief	[Private] Return packed code of a digit run character
+
+	\param[in]	c: character
+	\return	0 to 9 for digits, 10 for '.', 11 for '-', 0xff for other characters
+
+*/
+uint8_t FF_A6compress::digitCode(const char c) {
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c == '.') return 10;
+	if (c == '-') return 11;
+	return 0xff;
+}
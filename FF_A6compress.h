@@ -0,0 +1,53 @@
+/*!
+	\file
+	\brief	Static dictionary compressor for short machine generated messages
+	\author	Flying Domotic
+	\date	October 17th, 2026
+
+	Have a look at FF_A6compress.cpp for details
+
+*/
+
+#ifndef FF_A6compress_h
+#define FF_A6compress_h
+
+#include <Arduino.h>
+
+// Constants
+#define A6_COMPRESS_PORT 0xA6C1								//!< Application port used to send compressed messages
+#define A6_COMPRESS_BUILTIN_DICTIONARY 1					//!< Identifier of built-in dictionary
+#define A6_COMPRESS_MIN_DIGITS 6							//!< Minimum length of a packed digits run
+#define A6_COMPRESS_FIRST_WORD 0x80							//!< Code of first dictionary word
+#define A6_COMPRESS_MAX_WORDS 112							//!< Max count of dictionary words (codes 0x80 to 0xef)
+#define A6_COMPRESS_DIGITS 0xfe								//!< Code introducing a packed digits run
+#define A6_COMPRESS_ESCAPE 0xff								//!< Code introducing a literal byte (>= 0x80)
+
+class FF_A6compress {
+public:
+	/*!	\class FF_A6compress
+		\brief Static dictionary compressor for short machine generated messages
+
+		Compressed data starts with dictionary identifier, followed by codes:
+			- 0x00 to 0x7f: literal ASCII character,
+			- 0x80 to 0xef: dictionary word,
+			- 0xfe, count, packed digits: run of digits, '.' and '-' (2 per byte),
+			- 0xff, byte: literal byte (UTF-8 sequences).
+
+		Both peers should use the same dictionary. Default one is tuned for key=value telemetry.
+	*/
+
+	// Public routines (documented in FF_A6compress.cpp)
+	static void setDictionary(const char* words, const uint8_t dictionaryId);
+	static uint16_t compress(const char* text, const uint16_t len, uint8_t* out, const uint16_t outSize);
+	static uint16_t decompress(const uint8_t* in, const uint16_t len, char* out, const uint16_t outSize);
+
+private:
+	// Private routines (documented in FF_A6compress.cpp)
+	static const char* word(const uint8_t index, uint8_t& wordLen);
+	static uint8_t digitCode(const char c);
+
+	// Private variables
+	static const char* dictionary;							//!< Packed dictionary (words separated by zeros, ending with an empty word)
+	static uint8_t dictionaryId;							//!< Identifier of dictionary
+};
+#endif
@@ -0,0 +1,235 @@
+/*!
+	\file
+	\brief	Bounded history of recent messages, used by FF_A6lib
+	\author	Flying Domotic
+	\date	October 17th, 2026
+*/
+
+#include <FF_A6history.h>
+
+// Class constructor : init some variables
+FF_A6history::FF_A6history() {
+	clear();
+}
+
+/*!
+
+	\brief	Add a message to history
+
+	\param[in]	time: message time (local time, seconds since 01/01/1970)
+	\param[in]	number: phone number
+	\param[in]	message: message (NULL to only reserve space, to be written by caller)
+	\param[in]	length: message length (bytes)
+	\return	Pointer to message copy in history (zero terminated, may be modified in place without exceeding length), NULL if message is too long
+
+*/
+char* FF_A6history::add(const uint32_t time, const char* number, const char* message, const uint16_t length) {
+	uint8_t numberLen = strnlen(number, 254) + 1;
+	uint32_t recordLen = A6_HISTORY_HEADER_LEN + numberLen + length + 1;
+	if (recordLen > sizeof(arena)) {
+		return NULL;
+	}
+	if (recordCount >= A6_HISTORY_MAX_COUNT) {
+		dropOldest();
+	}
+	// Find contiguous space, dropping oldest records if needed
+	uint16_t pos;
+	while (true) {
+		if (!recordCount) {									// Empty history, restart at beginning
+			head = 0;
+			tail = 0;
+		}
+		if (recordCount && tail == head) {					// No space left
+		} else if (tail >= head) {							// Free space at end, and at beginning
+			if (sizeof(arena) - tail >= recordLen) {
+				pos = tail;
+				break;
+			}
+			if (head >= recordLen) {
+				if (tail < sizeof(arena)) arena[tail] = A6_HISTORY_WRAP;
+				pos = 0;
+				break;
+			}
+		} else if ((uint32_t) (head - tail) >= recordLen) {				// Free space between tail and head
+			pos = tail;
+			break;
+		}
+		dropOldest();
+	}
+	uint8_t* record = arena + pos;
+	record[0] = 0;
+	record[1] = numberLen;
+	record[2] = length & 0xff;								// Allocated length
+	record[3] = length >> 8;
+	record[4] = length & 0xff;								// Current length
+	record[5] = length >> 8;
+	memcpy(record + 6, &time, sizeof(time));
+	memcpy(record + A6_HISTORY_HEADER_LEN, number, numberLen - 1);
+	record[A6_HISTORY_HEADER_LEN + numberLen - 1] = 0;
+	char* text = (char*) record + A6_HISTORY_HEADER_LEN + numberLen;
+	if (message) {
+		memcpy(text, message, length);
+	} else {
+		memset(text, 0, length);
+	}
+	text[length] = 0;
+	newest = pos;
+	tail = pos + recordLen;
+	recordCount++;
+	return text;
+}
+
+/*!
+
+	\brief	Return newest message
+
+	\param[out]	entry: newest message
+	\return	false if history is empty
+
+*/
+bool FF_A6history::last(A6historyEntry& entry) {
+	if (!recordCount) {
+		return false;
+	}
+	readEntry(newest, entry);
+	return true;
+}
+
+/*!
+
+	\brief	Change length of newest message (after it has been modified in place)
+
+	\param[in]	length: new length (not greater than length given when message was added)
+	\return	none
+
+*/
+void FF_A6history::setLastLength(const uint16_t length) {
+	if (!recordCount) return;
+	uint8_t* record = arena + newest;
+	if (length > (record[2] | (record[3] << 8))) return;
+	record[A6_HISTORY_HEADER_LEN + record[1] + length] = 0;
+	record[4] = length & 0xff;								// Record keeps its size, only current length changes
+	record[5] = length >> 8;
+}
+
+/*!
+
+	\brief	Start walking history, from oldest to newest message
+
+	\param	none
+	\return	Iterator to give to next
+
+*/
+A6historyIterator FF_A6history::iterate(void) {
+	return A6historyIterator{head, recordCount};
+}
+
+/*!
+
+	\brief	Return next message of an history walk
+
+	\param[in,out]	iterator: iterator returned by iterate
+	\param[out]	entry: next message
+	\return	false if there are no more messages
+
+*/
+bool FF_A6history::next(A6historyIterator& iterator, A6historyEntry& entry) {
+	if (!iterator.left) {
+		return false;
+	}
+	if (iterator.offset >= sizeof(arena) || arena[iterator.offset] == A6_HISTORY_WRAP) {
+		iterator.offset = 0;
+	}
+	readEntry(iterator.offset, entry);
+	iterator.offset += recordLength(iterator.offset);
+	iterator.left--;
+	return true;
+}
+
+/*!
+
+	\brief	Check if a pointer lies inside history
+
+	Pointers returned by last() or next() become invalid when a message is added, callers should copy them before.
+
+	\param[in]	pointer: pointer to check
+	\return	true if pointer is inside history records
+
+*/
+bool FF_A6history::owns(const void* pointer) {
+	return (const uint8_t*) pointer >= arena && (const uint8_t*) pointer < arena + sizeof(arena);
+}
+
+/*!
+
+	\brief	Return count of messages in history
+
+	\param	none
+	\return	Count of messages
+
+*/
+uint16_t FF_A6history::count(void) {
+	return recordCount;
+}
+
+/*!
+
+	\brief	Remove all messages from history
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6history::clear(void) {
+	head = 0;
+	tail = 0;
+	newest = 0;
+	recordCount = 0;
+}
+
+/*!
+
+	\brief	[Private] Drop oldest message
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6history::dropOldest(void) {
+	if (!recordCount) return;
+	if (head >= sizeof(arena) || arena[head] == A6_HISTORY_WRAP) {
+		head = 0;
+	}
+	head += recordLength(head);
+	recordCount--;
+}
+
+/*!
+
+	\brief	[Private] Return total length of a record
+
+	\param[in]	offset: record offset
+	\return	Record length, including header and unused bytes of shortened messages
+
+*/
+uint16_t FF_A6history::recordLength(const uint16_t offset) {
+	const uint8_t* record = arena + offset;
+	return A6_HISTORY_HEADER_LEN + record[1] + (record[2] | (record[3] << 8)) + 1;
+}
+
+/*!
+
+	\brief	[Private] Read a record
+
+	\param[in]	offset: record offset
+	\param[out]	entry: message
+	\return	none
+
+*/
+void FF_A6history::readEntry(const uint16_t offset, A6historyEntry& entry) {
+	const uint8_t* record = arena + offset;
+	memcpy(&entry.time, record + 6, sizeof(entry.time));
+	entry.number = (const char*) record + A6_HISTORY_HEADER_LEN;
+	entry.message = (const char*) record + A6_HISTORY_HEADER_LEN + record[1];
+	entry.length = record[4] | (record[5] << 8);
+}
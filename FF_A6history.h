@@ -0,0 +1,89 @@
+/*!
+	\file
+	\brief	Bounded history of recent messages, used by FF_A6lib
+	\author	Flying Domotic
+	\date	October 17th, 2026
+
+	Have a look at FF_A6history.cpp for details
+
+*/
+
+#ifndef FF_A6history_h
+#define FF_A6history_h
+
+#include <Arduino.h>
+
+// Constants
+// FF_A6lib keeps a sent and a received history, using twice A6_HISTORY_SIZE bytes of RAM.
+//	As sent messages are built in history, A6_HISTORY_SIZE also limits their length (less header and number, about 6 GSM-7 SMS by default).
+#ifndef A6_HISTORY_SIZE
+	#define A6_HISTORY_SIZE 1024							//!< Size of each history arena (bytes), also limits length of sent messages
+#endif
+#ifndef A6_HISTORY_MAX_COUNT
+	#define A6_HISTORY_MAX_COUNT 20							//!< Max count of messages kept in each history
+#endif
+#define A6_HISTORY_HEADER_LEN 10								//!< Length of history record header
+#define A6_HISTORY_WRAP 0xff								//!< Marker of unused space at end of arena
+
+/*!
+	\struct A6historyEntry
+	\brief	Message kept in history (pointers are valid until next message is added)
+*/
+struct A6historyEntry {
+	uint32_t time;											//!< Message time (local time, seconds since 01/01/1970)
+	const char* number;										//!< Phone number
+	const char* message;									//!< Message (UTF-8)
+	uint16_t length;										//!< Message length (bytes)
+};
+
+/*!
+	\struct A6historyIterator
+	\brief	Position of an history walk
+*/
+struct A6historyIterator {
+	uint16_t offset;										//!< Offset of next record
+	uint16_t left;											//!< Count of records left
+};
+
+class FF_A6history {
+public:
+	/*!	\class FF_A6history
+		\brief Bounded history of recent messages
+
+		Messages are stored as variable length records in a ring arena: a header (marker, number length, allocated and current message length, time),
+			followed by number and message, both zero terminated. Oldest messages are dropped when arena or max count is reached.
+
+		\code
+			A6historyIterator it = a6.getReceivedHistory().iterate();
+			A6historyEntry entry;
+			while (a6.getReceivedHistory().next(it, entry)) {
+				Serial.printf("%s: %s\n", entry.number, entry.message);
+			}
+		\endcode
+	*/
+	FF_A6history();
+
+	// Public routines (documented in FF_A6history.cpp)
+	char* add(const uint32_t time, const char* number, const char* message, const uint16_t length);
+	bool last(A6historyEntry& entry);
+	void setLastLength(const uint16_t length);
+	A6historyIterator iterate(void);
+	bool next(A6historyIterator& iterator, A6historyEntry& entry);
+	uint16_t count(void);
+	bool owns(const void* pointer);
+	void clear(void);
+
+private:
+	// Private routines (documented in FF_A6history.cpp)
+	void dropOldest(void);
+	uint16_t recordLength(const uint16_t offset);
+	void readEntry(const uint16_t offset, A6historyEntry& entry);
+
+	// Private variables
+	uint8_t arena[A6_HISTORY_SIZE];							//!< Records
+	uint16_t head;											//!< Offset of oldest record
+	uint16_t tail;											//!< Offset after newest record
+	uint16_t newest;										//!< Offset of newest record
+	uint16_t recordCount;									//!< Count of records
+};
+#endif
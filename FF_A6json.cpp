@@ -0,0 +1,317 @@
+/*!
+	\file
+	\brief	Streaming JSON writer, used by FF_A6lib to output status without building Strings
+	\author	Flying Domotic
+	\date	October 17th, 2026
+*/
+
+#include <FF_A6json.h>
+
+// Class constructor : init some variables
+FF_A6json::FF_A6json(Print& out) {
+	output = &out;
+	chunkCb = NULL;
+	chunkLen = 0;
+	depth = 0;
+	overflow = 0;
+	firstItem = 1;
+}
+
+// Class constructor : init some variables
+FF_A6json::FF_A6json(void (*chunkCallback)(const char* data, const size_t length)) {
+	output = NULL;
+	chunkCb = chunkCallback;
+	chunkLen = 0;
+	depth = 0;
+	overflow = 0;
+	firstItem = 1;
+}
+
+// Class destructor : write last chunk
+FF_A6json::~FF_A6json() {
+	flush();
+}
+
+/*!
+
+	\brief	Start an object
+
+	\param[in]	key: object key (NULL in an array or at top level)
+	\return	none
+
+*/
+void FF_A6json::beginObject(const char* key) {
+	separator(key);
+	writeChar('{');
+	enterLevel();
+}
+
+/*!
+
+	\brief	End current object
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6json::endObject(void) {
+	leaveLevel();
+	writeChar('}');
+}
+
+/*!
+
+	\brief	Start an array
+
+	\param[in]	key: array key (NULL in an array or at top level)
+	\return	none
+
+*/
+void FF_A6json::beginArray(const char* key) {
+	separator(key);
+	writeChar('[');
+	enterLevel();
+}
+
+/*!
+
+	\brief	End current array
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6json::endArray(void) {
+	leaveLevel();
+	writeChar(']');
+}
+
+/*!
+
+	\brief	Add a string value
+
+	\param[in]	key: value key (NULL in an array)
+	\param[in]	value: zero terminated UTF-8 string (NULL gives null)
+	\return	none
+
+*/
+void FF_A6json::addString(const char* key, const char* value) {
+	if (!value) {
+		addNull(key);
+		return;
+	}
+	addString(key, value, strlen(value));
+}
+
+/*!
+
+	\brief	Add a string value with given length
+
+	\param[in]	key: value key (NULL in an array)
+	\param[in]	value: UTF-8 string
+	\param[in]	length: string length (bytes)
+	\return	none
+
+*/
+void FF_A6json::addString(const char* key, const char* value, const uint16_t length) {
+	separator(key);
+	writeString(value, length, false);
+}
+
+/*!
+
+	\brief	Add a signed number value
+
+	\param[in]	key: value key (NULL in an array)
+	\param[in]	value: number
+	\return	none
+
+*/
+void FF_A6json::addInt(const char* key, const int32_t value) {
+	char buffer[12];
+	separator(key);
+	snprintf_P(buffer, sizeof(buffer), PSTR("%ld"), (long) value);
+	writeRaw(buffer);
+}
+
+/*!
+
+	\brief	Add an unsigned number value
+
+	\param[in]	key: value key (NULL in an array)
+	\param[in]	value: number
+	\return	none
+
+*/
+void FF_A6json::addUInt(const char* key, const uint32_t value) {
+	char buffer[12];
+	separator(key);
+	snprintf_P(buffer, sizeof(buffer), PSTR("%lu"), (unsigned long) value);
+	writeRaw(buffer);
+}
+
+/*!
+
+	\brief	Add a boolean value
+
+	\param[in]	key: value key (NULL in an array)
+	\param[in]	value: boolean
+	\return	none
+
+*/
+void FF_A6json::addBool(const char* key, const bool value) {
+	separator(key);
+	writeRaw(value ? "true" : "false");
+}
+
+/*!
+
+	\brief	Add a null value
+
+	\param[in]	key: value key (NULL in an array)
+	\return	none
+
+*/
+void FF_A6json::addNull(const char* key) {
+	separator(key);
+	writeRaw("null");
+}
+
+/*!
+
+	\brief	Give pending chunk to output
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6json::flush(void) {
+	if (!chunkLen) return;
+	if (output) {
+		output->write((const uint8_t*) chunk, chunkLen);
+	} else if (chunkCb) {
+		(*chunkCb)(chunk, chunkLen);
+	}
+	chunkLen = 0;
+}
+
+/*!
+
+	\brief	[Private] Write comma if needed, then key
+
+	\param[in]	key: item key, may be in PROGMEM (NULL if none)
+	\return	none
+
+*/
+void FF_A6json::separator(const char* key) {
+	if (firstItem & (1 << depth)) {
+		firstItem &= ~(1 << depth);
+	} else {
+		writeChar(',');
+	}
+	if (key) {
+		writeString(key, strlen_P(key), true);
+		writeChar(':');
+	}
+}
+
+/*!
+
+	\brief	[Private] Enter a new nesting level
+
+	Levels deeper than A6_JSON_MAX_DEPTH are only counted, items written there sharing last level comma state.
+		Output stays valid as long as each begin is matched by an end.
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6json::enterLevel(void) {
+	if (depth < A6_JSON_MAX_DEPTH - 1) {
+		depth++;
+	} else {
+		overflow++;
+	}
+	firstItem |= 1 << depth;
+}
+
+/*!
+
+	\brief	[Private] Leave current nesting level
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6json::leaveLevel(void) {
+	if (overflow) {
+		overflow--;
+		firstItem &= ~(1 << depth);								// Level above overflow already contains at least one item
+	} else if (depth) {
+		depth--;
+	}
+}
+
+/*!
+
+	\brief	[Private] Write a character, giving chunk to output when full
+
+	\param[in]	c: character to write
+	\return	none
+
+*/
+void FF_A6json::writeChar(const char c) {
+	if (chunkLen >= sizeof(chunk)) {
+		flush();
+	}
+	chunk[chunkLen++] = c;
+}
+
+/*!
+
+	\brief	[Private] Write a text as is
+
+	\param[in]	text: text to write
+	\return	none
+
+*/
+void FF_A6json::writeRaw(const char* text) {
+	while (*text) {
+		writeChar(*text++);
+	}
+}
+
+/*!
+
+	\brief	[Private] Write a quoted and escaped string
+
+	\param[in]	text: string to write
+	\param[in]	length: string length (bytes)
+	\param[in]	progmem: true if string is in PROGMEM
+	\return	none
+
+*/
+void FF_A6json::writeString(const char* text, const uint16_t length, const bool progmem) {
+	static const char hexDigits[] = "0123456789abcdef";
+	writeChar('"');
+	for (uint16_t i = 0; i < length; i++) {
+		char c = progmem ? (char) pgm_read_byte(text + i) : text[i];
+		if (c == '"' || c == '\\') {
+			writeChar('\\');
+			writeChar(c);
+		} else if (c == '\n') {
+			writeChar('\\');
+			writeChar('n');
+		} else if (c == '\r') {
+			writeChar('\\');
+			writeChar('r');
+		} else if ((uint8_t) c < 0x20) {					// Other control characters
+			writeRaw("\\u00");
+			writeChar(hexDigits[(uint8_t) c >> 4]);
+			writeChar(hexDigits[c & 0x0f]);
+		} else {
+			writeChar(c);
+		}
+	}
+	writeChar('"');
+}
@@ -0,0 +1,79 @@
+/*!
+	\file
+	\brief	Streaming JSON writer, used by FF_A6lib to output status without building Strings
+	\author	Flying Domotic
+	\date	October 17th, 2026
+
+	Have a look at FF_A6json.cpp for details
+
+*/
+
+#ifndef FF_A6json_h
+#define FF_A6json_h
+
+#include <Arduino.h>
+
+// Constants
+#ifndef A6_JSON_CHUNK_SIZE
+	#define A6_JSON_CHUNK_SIZE 128							//!< Size of output chunks (bytes)
+#endif
+#define A6_JSON_MAX_DEPTH 16								//!< Max nesting of objects and arrays
+
+class FF_A6json {
+public:
+	/*!	\class FF_A6json
+		\brief Streaming JSON writer
+
+		JSON text is written in a fixed size buffer, given to output each time it's full, so RAM used doesn't depend on document size.
+			Output may be any Print (Serial, file, asynchronous web server response stream...) or a routine receiving chunks
+			(for example calling sendContent() of an ESP8266WebServer after setContentLength(CONTENT_LENGTH_UNKNOWN)).
+
+		Commas are inserted automatically. Keys may be in PROGMEM (PSTR), string values must be in RAM.
+
+		\code
+			FF_A6json json(Serial);
+			json.beginObject();
+			json.addString(PSTR("name"), "A6");
+			json.beginArray(PSTR("values"));
+			json.addInt(NULL, 12);
+			json.endArray();
+			json.endObject();
+			json.flush();
+		\endcode
+	*/
+	FF_A6json(Print& output);
+	FF_A6json(void (*chunkCallback)(const char* data, const size_t length));
+	~FF_A6json();
+
+	// Public routines (documented in FF_A6json.cpp)
+	void beginObject(const char* key = NULL);
+	void endObject(void);
+	void beginArray(const char* key = NULL);
+	void endArray(void);
+	void addString(const char* key, const char* value);
+	void addString(const char* key, const char* value, const uint16_t length);
+	void addInt(const char* key, const int32_t value);
+	void addUInt(const char* key, const uint32_t value);
+	void addBool(const char* key, const bool value);
+	void addNull(const char* key);
+	void flush(void);
+
+private:
+	// Private routines (documented in FF_A6json.cpp)
+	void enterLevel(void);
+	void leaveLevel(void);
+	void separator(const char* key);
+	void writeChar(const char c);
+	void writeRaw(const char* text);
+	void writeString(const char* text, const uint16_t length, const bool progmem);
+
+	// Private variables
+	Print* output;											//!< Output (NULL if chunk callback is used)
+	void (*chunkCb)(const char* data, const size_t length);	//!< Chunk callback (NULL if output is used)
+	char chunk[A6_JSON_CHUNK_SIZE];							//!< Chunk being filled
+	uint16_t chunkLen;										//!< Used length of chunk
+	uint8_t depth;											//!< Current nesting level
+	uint16_t overflow;										//!< Count of levels opened beyond A6_JSON_MAX_DEPTH
+	uint16_t firstItem;										//!< One bit per nesting level, set while no item written at this level
+};
+#endif
@@ -13,12 +13,69 @@ Todo:
 */
 
 #include <FF_A6lib.h>
+#include <FF_A6pdu.h>
+#include <FF_A6text.h>
+#include <FF_A6clock.h>
 #include <FF_Trace.h>
-#include <NtpClientLib.h>									// https://github.com/gmag11/NtpClient
 #include <pdulib.h>											// https://github.com/mgaman/PDUlib
 
 #define PDU_BUFFER_LENGTH 1024								// Max workspace length
 PDU smsPdu = PDU(PDU_BUFFER_LENGTH);						// Instantiate PDU class
+FF_A6pdu a6Pdu;												// Instantiate PDU encoder (pdulib is only used to decode received messages)
+
+#ifdef FF_A6LIB_HEAP_STATS									// Define FF_A6LIB_HEAP_STATS to account heap usage of main operations
+	#include <umm_malloc/umm_malloc.h>
+	// Measure heap during a routine, and update its counters
+	//	With UMM_STATS_FULL (build flag of ESP8266 core), allocations are counted and peak comes from umm_malloc low-water mark,
+	//		so memory allocated then freed before return (like a String temporary) is seen.
+	//	Else, only heap retained at exit is measured.
+	class A6heapProbe {
+	public:
+		A6heapProbe(A6heapStats& operationStats) : stats(operationStats), freeAtEntry(ESP.getFreeHeap()) {
+			parent = current;
+			current = this;
+			#ifdef UMM_STATS_FULL
+				lowestFree = umm_free_heap_size_lw_min();
+				if (parent && lowestFree < parent->lowestFree) parent->lowestFree = lowestFree;	// Keep caller low-water mark before resetting it
+				umm_free_heap_size_min_reset();
+				lowestFree = freeAtEntry;
+				allocationsAtEntry = umm_get_malloc_count() + umm_get_realloc_count();
+			#else
+				lowestFree = freeAtEntry;
+			#endif
+		}
+		~A6heapProbe() {
+			uint32_t freeAtExit = ESP.getFreeHeap();
+			long delta = (long) freeAtEntry - (long) freeAtExit;
+			#ifdef UMM_STATS_FULL
+				uint32_t lowWater = umm_free_heap_size_lw_min();
+				if (lowWater < lowestFree) lowestFree = lowWater;
+				stats.allocations += umm_get_malloc_count() + umm_get_realloc_count() - allocationsAtEntry;
+			#endif
+			if (freeAtExit < lowestFree) lowestFree = freeAtExit;
+			stats.calls++;
+			stats.totalDelta += delta;
+			if (delta > 0) stats.growingCalls++;
+			if (freeAtEntry > lowestFree && freeAtEntry - lowestFree > stats.peakUsage) stats.peakUsage = freeAtEntry - lowestFree;
+			if (!stats.minFreeHeap || lowestFree < stats.minFreeHeap) stats.minFreeHeap = lowestFree;
+			if (parent && lowestFree < parent->lowestFree) parent->lowestFree = lowestFree;
+			current = parent;
+		}
+	private:
+		static A6heapProbe* current;						// Innermost running probe
+		A6heapProbe* parent;								// Probe of calling operation (NULL if none)
+		A6heapStats& stats;
+		uint32_t freeAtEntry;
+		uint32_t lowestFree;
+		#ifdef UMM_STATS_FULL
+			size_t allocationsAtEntry;
+		#endif
+	};
+	A6heapProbe* A6heapProbe::current = NULL;
+	#define A6_HEAP_PROBE(operation) A6heapProbe heapProbe(heapStats[operation])
+#else
+	#define A6_HEAP_PROBE(operation)
+#endif
 
 #ifdef USE_SOFTSERIAL_FOR_A6LIB                             // Define USE_SOFTSERIAL_FOR_A6LIB to use SofwareSerial instead of Serial
     #include <SoftwareSerial.h>
@@ -53,12 +110,9 @@ FF_A6lib::FF_A6lib() {
 	smsReadCount = 0;
 	smsForwardedCount = 0;
 	smsSentCount = 0;
-	lastReceivedNumber = PSTR("[none]");
-	lastReceivedDate = PSTR("[never]");
-	lastReceivedMessage = PSTR("[no message]");
-	lastSentNumber = PSTR("[none]");
-	lastSentDate = PSTR("[never]");
-	lastSentMessage = PSTR("[no message]");
+	memset(lastReceivedDate, 0, sizeof(lastReceivedDate));
+	memset(smsAddress, 0, sizeof(smsAddress));
+	memset(lastSentDate, 0, sizeof(lastSentDate));
     ignoreErrors = false;
     startTime = 0;
     restartCount = 0;
@@ -73,6 +127,84 @@ FF_A6lib::FF_A6lib() {
     memset(expectedAnswer, 0, sizeof(expectedAnswer));
     memset(lastCommand, 0, sizeof(lastCommand));
     smsMsgId = 0;
+    smsChunkStart = 0;
+    smsPduText = NULL;
+    smsDcs = A6_DCS_GSM7;
+    smsLockingShift = A6_LANG_DEFAULT;
+    smsSingleShift = A6_LANG_DEFAULT;
+    transliterateFlag = false;
+    lastTransliterationSaving = 0;
+    transliterationSavedCount = 0;
+    readBinaryCb = NULL;
+    binaryLength = 0;
+    binaryDestinationPort = 0;
+    binarySourcePort = 0;
+    memset(binaryRecvSender, 0, sizeof(binaryRecvSender));
+    binaryRecvReference = 0;
+    binaryRecvCount = 0;
+    binaryRecvMask = 0;
+    binaryRecvLength = 0;
+    concatReference16 = true;
+    referenceCounter = 0;
+    referenceFs = NULL;
+    memset(referenceFile, 0, sizeof(referenceFile));
+    memset(referenceTable, 0, sizeof(referenceTable));
+    scaFs = NULL;
+    memset(scaFile, 0, sizeof(scaFile));
+    memset(iccid, 0, sizeof(iccid));
+    memset(currentSca, 0, sizeof(currentSca));
+    scaCheckNeeded = false;
+    modemBaudRate = 0;
+    powerDriver = NULL;
+    powerState = A6_POWER_IDLE;
+    powerStepTime = 0;
+    recoveryMethod = A6_RECOVER_NONE;
+    recoveryAttempts = 0;
+    recoveryStartTime = 0;
+    memset(recoveryStats, 0, sizeof(recoveryStats));
+    heartbeatInterval = 0;
+    heartbeatTime = 0;
+    heartbeatHistory = 0;
+    heartbeatMisses = 0;
+    backgroundCheck = false;
+    heartbeatCount = 0;
+    heartbeatFailCount = 0;
+    timeoutFloor = 0;
+    timeoutCeiling = 0;
+    memset(latencies, 0, sizeof(latencies));
+    latencySlot = A6_LATENCY_NONE;
+    queueHead = 0;
+    queueTail = 0;
+    queueCount = 0;
+    queueDroppedCount = 0;
+    beginTime = 0;
+    messageStartTime = 0;
+    chunkStartTime = 0;
+    messageInProgress = false;
+    memset(&perfStats, 0, sizeof(perfStats));
+    timeSourceCb = NULL;
+    clockBase = 0;
+    clockBaseMillis = 0;
+    modemClockFlag = false;
+    modemScaFlag = false;
+    timeZone = 0;
+    readTimedSmsCb = NULL;
+    memset(delayHistogram, 0, sizeof(delayHistogram));
+    delayUnknownCount = 0;
+    memset(dedupCache, 0, sizeof(dedupCache));
+    dedupNext = 0;
+    dedupWindow = A6_DEDUP_WINDOW;
+    duplicateCount = 0;
+    router = NULL;
+    routedCount = 0;
+    messageLog = NULL;
+    allowList = NULL;
+    blockList = NULL;
+    droppedInboundCount = 0;
+    suppressedOutboundCount = 0;
+    #ifdef FF_A6LIB_HEAP_STATS
+        memset(heapStats, 0, sizeof(heapStats));
+    #endif
 }
 
 /*!
@@ -94,9 +226,11 @@ void FF_A6lib::begin(long baudRate, int8_t rxPin, int8_t txPin) {
 	inWait = false;
 	gsmIdle = A6_STARTING;
     ignoreErrors = true;
+	beginTime = millis();
 	// Save RX pin, TX pin and requested speed
 	modemRxPin = rxPin;
 	modemTxPin = txPin;
+	modemBaudRate = baudRate;
 	// Open modem at requested speed initially
 	openModem(baudRate);
     sendCommand("AT", &FF_A6lib::setReset);
@@ -114,6 +248,41 @@ void FF_A6lib::begin(long baudRate, int8_t rxPin, int8_t txPin) {
 */
 void FF_A6lib::doLoop(void) {
 	if (traceFlag) enterRoutine(__func__);
+	A6_HEAP_PROBE(A6_HEAP_DO_LOOP);
+
+	// Run reset or power cycle, if any (modem answers are read while probing it)
+	if (powerState != A6_POWER_IDLE && powerState != A6_POWER_PROBING) {
+		powerStep();
+		return;
+	}
+
+	// Escalate a failed recovery, up to strongest method
+	if (restartNeeded && recoveryMethod != A6_RECOVER_NONE && recoveryMethodAt(recoveryAttempts + 1) != recoveryMethod) {
+		trace_warn_P("Recovery method %d failed", recoveryMethod);
+		recover();
+		return;
+	}
+
+	// Send next queued message if modem is idle
+	if (queueCount && gsmIdle == A6_IDLE && !restartNeeded) {
+		sendQueued();
+	}
+
+	// Check SCA loaded from store if modem is idle
+	if (scaCheckNeeded && !modemScaFlag && !queueCount && gsmIdle == A6_IDLE && !restartNeeded) {
+		checkSca();
+	}
+
+	// Check modem is still alive if idle for a while
+	if (heartbeatInterval && !queueCount && gsmIdle == A6_IDLE && !restartNeeded && !inReceive
+			&& millis() - heartbeatTime >= heartbeatDelay()) {
+		heartbeat();
+	}
+
+	// Write logged messages if modem is idle
+	if (messageLog && gsmIdle == A6_IDLE) {
+		messageLog->loop();
+	}
 
 	// Read modem until \n (LF) character found, removing \r (CR)
 		size_t answerLen = strlen(lastAnswer);				// Get answer length
@@ -145,6 +314,7 @@ void FF_A6lib::doLoop(void) {
 						bool isDefaultAnwer = !(strcmp(expectedAnswer, DEFAULT_ANSWER));
 						if ((isDefaultAnwer && !strcmp(lastAnswer, expectedAnswer)) || (!isDefaultAnwer && strstr(lastAnswer, expectedAnswer))) {
 							if (debugFlag) trace_debug_P("Reply in %d ms: >%s<", millis() - startTime, lastAnswer);
+							recordLatency(millis() - startTime);
 							gsmStatus = A6_OK;
 							if (nextStepCb) {				// Do we have another callback to execute?
 								(this->*nextStepCb)();		// Yes, do it
@@ -157,6 +327,12 @@ void FF_A6lib::doLoop(void) {
 							// No, check for CMS/CME error
 							if (strstr(lastAnswer,"+CMS ERROR") || strstr(lastAnswer,"+CME ERROR")) {
 								// This is a CMS or CME answer
+								if (backgroundCheck) {		// Let background check handle its failure
+									trace_warn_P("Check error: >%s< after %d ms, command was %s", lastAnswer, millis() - startTime, lastCommand);
+									gsmStatus = A6_CM_ERROR;
+									(this->*nextStepCb)();
+									return;
+								}
 								trace_error_P("Error answer: >%s< after %d ms, command was %s", lastAnswer, millis() - startTime, lastCommand);
 								gsmStatus = A6_CM_ERROR;
 								restartNeeded = true;
@@ -181,7 +357,9 @@ void FF_A6lib::doLoop(void) {
 								readSmsHeader(lastAnswer);
 								resetLastAnswer();
 								inReceive = true;
+								backgroundCheck = false;	// SMS reception replaces any background check
                             gsmTimeout = 2000;
+								latencySlot = A6_LATENCY_NONE;
 								startTime = millis();
 								return;
 							} else {								// Can't understand received data
@@ -202,6 +380,7 @@ void FF_A6lib::doLoop(void) {
 					// Check for one character answer (like '>' when sending SMS) which have no <CR><LF>
 					if (strlen(expectedAnswer) == 1 && c == expectedAnswer[0]) {
 						if (debugFlag) trace_debug_P("Reply in %d ms: >%s<", millis() - startTime, lastAnswer);
+						recordLatency(millis() - startTime);
 						gsmStatus = A6_OK;
 						if (nextStepCb) {				// Do we have another callback to execute?
 							(this->*nextStepCb)();		// Yes, do it
@@ -224,7 +403,12 @@ void FF_A6lib::doLoop(void) {
 
 	if (inReceive) {										// We're waiting for a command answer
 		if ((millis() - startTime) >= gsmTimeout) {
-			if (ignoreErrors) {								// If errors should be ignored, call next step, if any
+			if (ignoreErrors || backgroundCheck) {			// Time out is expected when errors are ignored, don't sample it
+				latencySlot = A6_LATENCY_NONE;
+			} else {
+				recordLatency(gsmTimeout);					// Latency is at least timeout
+			}
+			if (ignoreErrors || backgroundCheck) {			// If errors should be ignored, call next step, if any
 				trace_error_P("Ignoring time out after %d ms, received >%s<, command was %s", millis() - startTime, lastAnswer, lastCommand);
 				if (nextStepCb) {							// Do we have another callback to execute?
 					(this->*nextStepCb)();					// Yes, do it
@@ -310,6 +494,40 @@ void FF_A6lib::debugState(void) {
 	trace_info_P("smsReadCount=%d", smsReadCount);
 	trace_info_P("smsForwardedCount=%d", smsForwardedCount);
 	trace_info_P("smsSentCount=%d", smsSentCount);
+	trace_info_P("transliterationSavedCount=%d", transliterationSavedCount);
+	trace_info_P("bootTime=%d", perfStats.bootTime);
+	trace_info_P("messageCount=%d, avg=%d ms, max=%d ms", perfStats.messageCount,
+		perfStats.messageCount ? perfStats.messageTotalTime / perfStats.messageCount : 0, perfStats.messageMaxTime);
+	trace_info_P("chunkCount=%d, avg=%d ms, max=%d ms", perfStats.chunkCount,
+		perfStats.chunkCount ? perfStats.chunkTotalTime / perfStats.chunkCount : 0, perfStats.chunkMaxTime);
+	#ifdef FF_A6LIB_HEAP_STATS
+		for (uint8_t i = 0; i < A6_HEAP_OPERATIONS; i++) {
+			trace_info_P("heap[%d]: calls=%d, growing=%d, delta=%d, allocations=%d, peak=%d, minFree=%d", i, heapStats[i].calls,
+				heapStats[i].growingCalls, heapStats[i].totalDelta, heapStats[i].allocations, heapStats[i].peakUsage, heapStats[i].minFreeHeap);
+		}
+	#endif
+	trace_info_P("delays=%d/%d/%d/%d/%d/%d/%d/%d, unknown=%d", delayHistogram[0], delayHistogram[1], delayHistogram[2], delayHistogram[3],
+		delayHistogram[4], delayHistogram[5], delayHistogram[6], delayHistogram[7], delayUnknownCount);
+	trace_info_P("duplicateCount=%d", duplicateCount);
+	trace_info_P("routedCount=%d", routedCount);
+	trace_info_P("droppedInboundCount=%d", droppedInboundCount);
+	trace_info_P("suppressedOutboundCount=%d", suppressedOutboundCount);
+	trace_info_P("queueCount=%d", queueCount);
+	trace_info_P("queueDroppedCount=%d", queueDroppedCount);
+	trace_info_P("referenceCounter=%d (%d bits)", referenceCounter, concatReference16 ? 16 : 8);
+	for (uint8_t i = 0; i < A6_RECOVER_METHODS; i++) {
+		trace_info_P("recovery[%d]: count=%d, success=%d, avg=%d ms, max=%d ms", i, recoveryStats[i].count, recoveryStats[i].successCount,
+			recoveryStats[i].successCount ? recoveryStats[i].totalTime / recoveryStats[i].successCount : 0, recoveryStats[i].maxTime);
+	}
+	trace_info_P("heartbeatCount=%d, failed=%d, history=0x%02x, delay=%d ms", heartbeatCount, heartbeatFailCount, heartbeatHistory,
+		heartbeatInterval ? heartbeatDelay() : 0);
+	for (uint8_t i = 0; i < A6_LATENCY_SLOTS; i++) {
+		if (latencies[i].command[0]) {
+			trace_info_P("latency[%s]: avg=%d ms, dev=%d ms, count=%d", latencies[i].command, latencies[i].average,
+				latencies[i].deviation, latencies[i].count);
+		}
+	}
+	trace_info_P("iccid=%s, sca=%s, scaCheckNeeded=%d, modemSca=%d", iccid, currentSca, scaCheckNeeded, modemScaFlag);
 	trace_info_P("a6-debugFlag=%d", debugFlag);
 	trace_info_P("a6-traceFlag=%d", traceFlag);
 	trace_info_P("a6-traceEnterFlag=%d", traceEnterFlag);
@@ -317,354 +535,1973 @@ void FF_A6lib::debugState(void) {
 
 /*!
 
-	\brief	Sends an SMS to modem
+	\brief	Write status as JSON
 
-	This routine pushes an SMS to modem.
-		It determines if message is a GMS7 only message or not (in this case, this will be UCS-2)
-		If message is GSM7, max length of non chunked SMS is 160. For UCS-2, this is 70.
-		When message is longer than these limits, it'll be split in chunks of 153 chars for GSM7, or 67 chars for UCS-2.
-		There's a theoretical limit of 255 chunks, but most of operators are limiting in lower size.
-		It seems that 7 to 8 messages are accepted by almost everyone, meaning 1200 GSM7 chars, or 550 UCS-2 chars.
+	JSON is streamed in chunks of A6_JSON_CHUNK_SIZE bytes, without building it in memory.
 
-	\param[in]	number: phone number to send message to
-	\param[in]	text: message to send
+	\param[in]	output: where to write JSON (Serial, file, asynchronous web server response stream...)
+	\param[in]	sections: sections to write (A6_JSON_STATUS, A6_JSON_COUNTERS, A6_JSON_QUEUE, A6_JSON_HISTORY, or A6_JSON_ALL)
 	\return	none
 
 */
-void FF_A6lib::sendSMS(const char* number, const char* text) {
-	uint16_t utf8Length = strlen(text);						// Size of UTF-8 message
-	uint8_t lengthToAdd;									// Length of one UTF-8 char in GSM-7 (or zero if UTF-8 input character outside GSM7 table)
-	uint8_t c1;												// First char of UTF-8 message
-	uint8_t c2;												// Second char of UTF-8 message
-	uint8_t c3;												// Third char of UTF-8 message
-	gsm7Length = 0;											// Size of GSM-7 message
-
-	for (uint16_t i = 0; i < utf8Length; i++) {				// Scan the full message
-		c1 = text[i];										// Extract first to third chars
-		if (i+1 < utf8Length) {c2 = text[i+1];} else {c2 = 0;}
-		if (i+2 < utf8Length) {c3 = text[i+2];} else {c3 = 0;}
-		lengthToAdd = getGsm7EquivalentLen(c1, c2, c3);		// Get equivalent GSM-7 length
-		if (lengthToAdd) {									// If char is GSM-7
-			gsm7Length += lengthToAdd;						// Add length
-		} else {
-			if (debugFlag) trace_info_P("Switched to UTF-8 on char %d (0x%02x) at pos %d", c1, c1, i);
-			gsm7Length = 0;									// Set length to zero
-			break;											// Exit loop
-		}
+void FF_A6lib::writeJson(Print& output, const uint8_t sections) {
+	if (traceFlag) enterRoutine(__func__);
+	FF_A6json json(output);
+	writeJsonContent(json, sections);
+}
+
+/*!
+
+	\brief	Write status as JSON, in chunks given to a routine
+
+	Allows writing into a chunked HTTP response (for example, with ESP8266WebServer, call server.setContentLength(CONTENT_LENGTH_UNKNOWN)
+		and server.send(200, "application/json", ""), then writeJson with a callback calling server.sendContent(data, length)).
+
+	\param[in]	chunkCallback: routine called with each chunk of JSON
+	\param[in]	sections: sections to write (A6_JSON_STATUS, A6_JSON_COUNTERS, A6_JSON_QUEUE, A6_JSON_HISTORY, or A6_JSON_ALL)
+	\return	none
+
+*/
+void FF_A6lib::writeJson(void (*chunkCallback)(const char* data, const size_t length), const uint8_t sections) {
+	if (traceFlag) enterRoutine(__func__);
+	FF_A6json json(chunkCallback);
+	writeJsonContent(json, sections);
+}
+
+/*!
+
+	\brief	[Private] Write status sections as a JSON object
+
+	\param[in]	json: JSON writer
+	\param[in]	sections: sections to write
+	\return	none
+
+*/
+void FF_A6lib::writeJsonContent(FF_A6json& json, const uint8_t sections) {
+	json.beginObject();
+	if (sections & A6_JSON_STATUS) {
+		json.beginObject(PSTR("status"));
+		json.addBool(PSTR("smsReady"), smsReady);
+		json.addInt(PSTR("gsmIdle"), gsmIdle);
+		json.addInt(PSTR("gsmStatus"), gsmStatus);
+		json.addBool(PSTR("restartNeeded"), restartNeeded);
+		json.addInt(PSTR("restartReason"), restartReason);
+		json.addString(PSTR("lastCommand"), lastCommand);
+		json.addString(PSTR("lastAnswer"), lastAnswer);
+		json.addString(PSTR("iccid"), iccid);
+		json.addString(PSTR("sca"), currentSca);
+		json.addUInt(PSTR("epoch"), getEpoch());
+		json.addUInt(PSTR("uptime"), millis() / 1000);
+		json.endObject();
 	}
-	
-	// Should we split message in chunks?
-	if (gsm7Length) {										// Is this a GSM-7 message ?
-		if (gsm7Length > 160) {								// This is a multi-part message
-			smsMsgCount = (gsm7Length + 151) / 152;			// Compute total chunks
-			smsMsgId++;
-			smsChunkSize = 152;
-		} else {
-			smsMsgCount = 0;
+	if (sections & A6_JSON_COUNTERS) {
+		json.beginObject(PSTR("counters"));
+		json.addUInt(PSTR("resetCount"), resetCount);
+		json.addUInt(PSTR("restartCount"), restartCount);
+		json.addUInt(PSTR("commandCount"), commandCount);
+		json.addUInt(PSTR("smsReadCount"), smsReadCount);
+		json.addUInt(PSTR("smsForwardedCount"), smsForwardedCount);
+		json.addUInt(PSTR("smsSentCount"), smsSentCount);
+		json.addUInt(PSTR("transliterationSavedCount"), transliterationSavedCount);
+		json.addUInt(PSTR("duplicateCount"), duplicateCount);
+		json.addUInt(PSTR("routedCount"), routedCount);
+		json.addUInt(PSTR("droppedInboundCount"), droppedInboundCount);
+		json.addUInt(PSTR("suppressedOutboundCount"), suppressedOutboundCount);
+		json.addUInt(PSTR("queueDroppedCount"), queueDroppedCount);
+		json.addUInt(PSTR("bootTime"), perfStats.bootTime);
+		json.addUInt(PSTR("messageCount"), perfStats.messageCount);
+		json.addUInt(PSTR("messageAvgTime"), perfStats.messageCount ? perfStats.messageTotalTime / perfStats.messageCount : 0);
+		json.addUInt(PSTR("messageMaxTime"), perfStats.messageMaxTime);
+		json.addUInt(PSTR("chunkCount"), perfStats.chunkCount);
+		json.addUInt(PSTR("chunkAvgTime"), perfStats.chunkCount ? perfStats.chunkTotalTime / perfStats.chunkCount : 0);
+		json.addUInt(PSTR("chunkMaxTime"), perfStats.chunkMaxTime);
+		json.beginArray(PSTR("delays"));
+		for (uint8_t i = 0; i < A6_DELAY_BUCKETS; i++) {
+			json.addUInt(NULL, delayHistogram[i]);
 		}
-		if (debugFlag) trace_info_P("gsm7, lenght=%d, msgs=%d", gsm7Length, smsMsgCount);
-	} else {												// This is an UCS-2 message
-		uint16_t ucs2Length = ucs2MessageLength(text);		// Get UCS-2 message length
-		if (ucs2Length > 70) {								// This is a multi-part message
-			smsMsgCount = (ucs2Length + 66) / 67;			// Compute total chunks
-			smsMsgId++;
-			smsChunkSize = 67;
-		} else {
-			smsMsgCount = 0;
+		json.endArray();
+		json.addUInt(PSTR("delayUnknownCount"), delayUnknownCount);
+		json.addUInt(PSTR("heartbeatCount"), heartbeatCount);
+		json.addUInt(PSTR("heartbeatFailCount"), heartbeatFailCount);
+		json.beginArray(PSTR("latency"));
+		for (uint8_t i = 0; i < A6_LATENCY_SLOTS; i++) {
+			if (!latencies[i].command[0]) continue;
+			json.beginObject();
+			json.addString(PSTR("command"), latencies[i].command);
+			json.addUInt(PSTR("average"), latencies[i].average);
+			json.addUInt(PSTR("deviation"), latencies[i].deviation);
+			json.addUInt(PSTR("count"), latencies[i].count);
+			json.endObject();
+		}
+		json.endArray();
+		json.beginArray(PSTR("recovery"));
+		for (uint8_t i = 0; i < A6_RECOVER_METHODS; i++) {
+			json.beginObject();
+			json.addUInt(PSTR("count"), recoveryStats[i].count);
+			json.addUInt(PSTR("successCount"), recoveryStats[i].successCount);
+			json.addUInt(PSTR("avgTime"), recoveryStats[i].successCount ? recoveryStats[i].totalTime / recoveryStats[i].successCount : 0);
+			json.addUInt(PSTR("maxTime"), recoveryStats[i].maxTime);
+			json.endObject();
 		}
-		if (debugFlag) trace_info_P("ucs2, length=%d, msgs=%d", ucs2Length, smsMsgCount);
+		json.endArray();
+		json.endObject();
 	}
-	// Save last used number and message
-	lastSentNumber = String(number);
-	lastSentMessage = String(text);
-	lastSentDate = NTP.getDateStr() + " " + NTP.getTimeStr();
-	// Send first (or only) SMS part
-	if (smsMsgCount == 0) {
-		sendOneSmsChunk(number, text);
-	} else {
-		smsMsgIndex = 0;
-		uint16_t startPos = smsMsgIndex++ * smsChunkSize;
-		sendOneSmsChunk(number, lastSentMessage.substring(startPos, startPos+smsChunkSize).c_str(), smsMsgId, smsMsgCount, smsMsgIndex);	// Send first chunk
+	if (sections & A6_JSON_QUEUE) {
+		json.beginArray(PSTR("queue"));
+		uint16_t pos = queueHead;
+		for (uint16_t i = 0; i < queueCount; i++) {
+			if (pos >= sizeof(queueArena) || queueArena[pos] == A6_QUEUE_WRAP) {
+				pos = 0;									// Record is at beginning of arena
+			}
+			const uint8_t* record = queueArena + pos;
+			uint8_t addressLen = record[1];
+			uint16_t len = record[2] | (record[3] << 8);
+			char number[A6_PDU_MAX_NUMBER];
+			FF_A6pdu::decodeNumber(record + A6_QUEUE_HEADER_LEN, number, sizeof(number));
+			json.beginObject();
+			json.addString(PSTR("type"), record[0] == A6_QUEUE_TEXT ? "text" : record[0] == A6_QUEUE_COMPRESSED ? "compressed" : "binary");
+			json.addString(PSTR("number"), number);
+			if (record[0] != A6_QUEUE_BINARY) {				// Text is stored with its final zero
+				json.addUInt(PSTR("length"), len ? len - 1 : 0);
+				json.addString(PSTR("message"), (const char*) record + A6_QUEUE_HEADER_LEN + addressLen, len ? len - 1 : 0);
+			} else {
+				json.addUInt(PSTR("length"), len);
+			}
+			json.endObject();
+			pos += A6_QUEUE_HEADER_LEN + addressLen + len;
+		}
+		json.endArray();
 	}
+	if (sections & A6_JSON_HISTORY) {
+		writeJsonHistory(json, PSTR("sent"), sentHistory);
+		writeJsonHistory(json, PSTR("received"), receivedHistory);
+	}
+	json.endObject();
 }
 
 /*!
 
-	\brief	Sends next SMS chunk to modem
-
-	This routine is called when an SMS chunk has been pushed to modem, to send next part, if it exists
+	\brief	[Private] Write a message history as a JSON array
 
-	\param	none
+	\param[in]	json: JSON writer
+	\param[in]	key: array key
+	\param[in]	history: history to write, oldest message first
 	\return	none
 
 */
-void FF_A6lib::sendNextSmsChunk(void){
-	if (smsMsgCount) {										// Are we in multi-part message ?
-		if (smsMsgIndex < smsMsgCount) {				// Do we have more chunks to send ?
-			uint16_t startPos = smsMsgIndex++ * smsChunkSize;
-			sendOneSmsChunk(lastSentNumber.c_str(), lastSentMessage.substring(startPos, startPos+smsChunkSize).c_str(), smsMsgId, smsMsgCount, smsMsgIndex);	// Send first chunk
-			return;
-		}
+void FF_A6lib::writeJsonHistory(FF_A6json& json, const char* key, FF_A6history& history) {
+	char date[A6_DATE_LEN];
+	A6historyEntry entry;
+	A6historyIterator iterator = history.iterate();
+	json.beginArray(key);
+	while (history.next(iterator, entry)) {
+		FF_A6clock::format(entry.time, date, sizeof(date));
+		json.beginObject();
+		json.addUInt(PSTR("time"), entry.time);
+		json.addString(PSTR("date"), date);
+		json.addString(PSTR("number"), entry.number);
+		json.addString(PSTR("message"), entry.message, entry.length);
+		json.endObject();
 	}
-	setIdle();												// Message has fully be sent
+	json.endArray();
 }
 
 /*!
 
-	\brief	Sends an SMS chunk to modem
+	\brief	Sends an SMS to modem
+
+	This routine pushes an SMS to modem.
+		It determines if message is a GMS7 only message or not (in this case, this will be UCS-2)
+		GSM7 messages may use national language (Turkish, Spanish, Portuguese) shift tables, chosen to minimize the count of SMS.
+		If message is GSM7, max length of non chunked SMS is 160. For UCS-2, this is 70.
+		When message is longer than these limits, it'll be split in chunks of 152 chars for GSM7, or 66 chars for UCS-2
+			(a bit less when national language tables are used).
+		There's a theoretical limit of 255 chunks, but most of operators are limiting in lower size.
+		It seems that 7 to 8 messages are accepted by almost everyone, meaning 1200 GSM7 chars, or 550 UCS-2 chars.
 
-	This routine pushes an SMS chunk to modem
+		When transliteration is enabled (see setTransliteration), characters outside default GSM-7 tables may be replaced.
 
 	\param[in]	number: phone number to send message to
 	\param[in]	text: message to send
-	\param[in]	msgId: SMS message identifier (should be incremented for each multi-part message, zero if not multi-part message)
-	\param[in]	msgCount: total number of SMS chunks (zero if not multi-part message)
-	\param[in]	msgIndex: index of this message chunk (zero if not multi-part message)
 	\return	none
 
 */
-void FF_A6lib::sendOneSmsChunk(const char* number, const char* text, const unsigned short msgId, const unsigned char msgCount, const unsigned char msgIndex) {
-	if (traceFlag) enterRoutine(__func__);
-	char tempBuffer[50];
-	int len = smsPdu.encodePDU(number, text, msgId, msgCount, msgIndex);
-	if (len < 0)  {
-			// -1: OBSOLETE_ERROR
-			// -2: UCS2_TOO_LONG
-			// -3 GSM7_TOO_LONG
-			// -4 MULTIPART_NUMBERS
-			// -5 ADDRESS_FORMAT
-			// -6 WORK_BUFFER_TOO_SMALL
-			// -7 ALPHABET_8BIT_NOT_SUPPORTED
-		trace_error_P("Encode error %d sending SMS to %s >%s<", len, number, text);
-		return;
+void FF_A6lib::sendSMS(const char* number, const char* text) {
+	A6_HEAP_PROBE(A6_HEAP_SEND_SMS);
+	if (!destinationAllowed(number) || !setDestination(number)) return;
+	uint16_t utf8Length = strlen(text);						// Size of UTF-8 message
+	// Resending a message from history, copy it before it gets overwritten by this new message
+	char numberCopy[A6_PDU_MAX_NUMBER];
+	if (sentHistory.owns(number)) {
+		strncpy(numberCopy, number, sizeof(numberCopy) - 1);
+		numberCopy[sizeof(numberCopy) - 1] = 0;
+		number = numberCopy;
+	}
+	if (sentHistory.owns(text)) {
+		if (utf8Length >= sizeof(textBuffer)) {
+			trace_error_P("Message too long to be resent (%d bytes)", utf8Length);
+			return;
+		}
+		memcpy(textBuffer, text, utf8Length + 1);
+		text = textBuffer;
 	}
 
-	if (debugFlag) trace_debug_P("Sending SMS to %s >%s<", number, text);
-	gsmIdle = A6_SEND;
-	smsSentCount++;
-	snprintf_P(tempBuffer, sizeof(tempBuffer),PSTR("AT+CMGS=%d"), len);
-	sendCommand(tempBuffer, &FF_A6lib::sendSMStext, ">");
+	uint16_t segments = selectAlphabet(text, utf8Length);	// Count of SMS needed
+	if (segments > 255) {									// Chunk count and index are sent on 8 bits
+		trace_error_P("Message too long (%d SMS)", segments);
+		return;
+	}
+	// Save message in history, this copy being also used to send message
+	char* message = sentHistory.add(getEpoch(), number, text, utf8Length);
+	if (!message) {
+		trace_error_P("Message too long (%d bytes)", utf8Length);
+		return;
+	}
+	sendSavedMessage(number, message, utf8Length, segments, text);
 }
 
 /*!
 
-	\brief	Register a SMS received callback routine
-
-	This routine register a callback routine to call when a SMS message is received
+	\brief	[Private] Sends a message already saved in sent history
 
-	Callback routine will be called with 4 parameters:
-		(int) index: not used yet
-		(char*) number: phone number of SMS sender
-		(char*) date: date of received SMS (as delivered by the network)
-		(char*) message: received message in UTF-8 encoding
+	Alphabet should have been selected (by selectAlphabet) for this message.
+		When transliteration is enabled, message may be transliterated in place, original being restored if this costs more SMS.
 
-	\param[in]	routine to call when a SMS is received
+	\param[in]	number: phone number to send message to
+	\param[in]	message: message in sent history (newest entry)
+	\param[in]	utf8Length: message length (bytes)
+	\param[in]	segments: count of SMS needed, as returned by selectAlphabet
+	\param[in]	original: copy of message outside history, used to restore it (NULL to copy it in text buffer when needed,
+		message longer than text buffer being then sent without transliteration)
 	\return	none
 
 */
-void FF_A6lib::registerSmsCb(void (*readSmsCallback)(int __index, const char* __number, const char* __date, const char* __message)) {
-	if (traceFlag) enterRoutine(__func__);
-	readSmsCb = readSmsCallback;
+void FF_A6lib::sendSavedMessage(const char* number, char* message, uint16_t utf8Length, uint16_t segments, const char* original) {
+	// Try to transliterate message if it doesn't fit in default GSM-7 tables
+	lastTransliterationSaving = 0;
+	bool needTransliteration = transliterateFlag && (smsDcs != A6_DCS_GSM7 || smsLockingShift || smsSingleShift);
+	if (needTransliteration && !original && utf8Length < sizeof(textBuffer)) {	// Keep a copy to restore message
+		memcpy(textBuffer, message, utf8Length + 1);
+		original = textBuffer;
+	}
+	if (needTransliteration && original) {
+		uint16_t replaced;
+		uint16_t newLength = FF_A6text::transliterate(message, utf8Length, replaced);
+		if (replaced) {
+			uint16_t newSegments = selectAlphabet(message, newLength);
+			if (newSegments <= segments) {					// Keep transliterated message
+				sentHistory.setLastLength(newLength);
+				lastTransliterationSaving = segments - newSegments;
+				transliterationSavedCount += lastTransliterationSaving;
+				if (debugFlag) trace_info_P("Transliterated %d chars, saved %d msgs", replaced, lastTransliterationSaving);
+				segments = newSegments;
+				utf8Length = newLength;
+			} else {										// Transliteration would cost more SMS (in UCS-2), restore message
+				memcpy(message, original, utf8Length);
+				message[utf8Length] = 0;
+				selectAlphabet(original, utf8Length);
+			}
+		}
+	}
+	smsMsgCount = (segments > 1) ? segments : 0;
+	if (smsMsgCount) {
+		smsMsgId = nextConcatReference(number);
+	}
+	// Send first (or only) SMS part
+	smsMsgIndex = 0;
+	smsChunkStart = 0;
+	if (smsMsgCount == 0) {
+		sendTextChunk(number, message, 0, utf8Length, 0, 0, 0);
+	} else {
+		sendNextSmsChunk();
+	}
 }
 
 /*!
 
-	\brief	Register an answer received callback routine
-
-	This routine register a callback routine to call when an answer is received from modem
+	\brief	[Private] Select alphabet used to send a message
 
-	Callback routine will be called with 1 parameter:
-		(char*) answer: received answer
+	This routine selects GSM-7 with national language tables giving the lowest count of SMS, or UCS-2 if not possible,
+		and computes corresponding chunk size
 
-	\param[in]	routine to call when a SMS is received
-	\return	none
+	\param[in]	text: message to send
+	\param[in]	utf8Length: message length (bytes)
+	\return	Count of SMS needed to send message
 
 */
-void FF_A6lib::registerLineCb(void (*recvLineCallback)(const char* __answer)) {
-	if (traceFlag) enterRoutine(__func__);
-	recvLineCb = recvLineCallback;
+uint16_t FF_A6lib::selectAlphabet(const char* text, const uint16_t utf8Length) {
+	A6messagePlan plan = FF_A6text::planMessage(text, utf8Length, concatUdhLen());
+	smsDcs = plan.dcs;
+	smsLockingShift = plan.lockingShift;
+	smsSingleShift = plan.singleShift;
+	smsChunkSize = plan.segmentCapacity;
+	if (debugFlag) trace_info_P("%s, length=%d, tables=%d/%d, msgs=%d", (plan.dcs == A6_DCS_GSM7) ? "gsm7" : "ucs2", plan.length, plan.lockingShift, plan.singleShift, plan.segmentCount);
+	return plan.segmentCount;
 }
 
 /*!
 
-	\brief	Delete SMS from the storage area
+	\brief	Plan how a message will be sent
 
-	This routine delete (some) SMS from storage using AT+CMGD command
-	\param[in]	index as used by AT+CMGD
-	\param[in]	flag as used by AT+CMGD
-	\return	none
+	This routine returns alphabet, count of SMS, position of each SMS in message and space left in last SMS, without sending anything.
+		It may be used to check the cost of a message before sending it.
+		FF_A6text::planMessage may be used instead to compute plan of constant messages at compile time.
 
-*/
-void FF_A6lib::deleteSMS(int index, int flag) {
-	if (traceFlag) enterRoutine(__func__);
-	char tempBuffer[50];
+	\param[in]	text: message to plan
+	\return	Message plan
 
-	snprintf_P(tempBuffer, sizeof(tempBuffer), PSTR("AT+CMGD=%d,%d"), index, flag);
-	sendCommand(tempBuffer, &FF_A6lib::setIdle, DEFAULT_ANSWER, 20000);	// Wait up to 20 seconds for OK
+*/
+A6messagePlan FF_A6lib::planMessage(const char* text) {
+	return FF_A6text::planMessage(text, strlen(text), concatUdhLen());
 }
 
 /*!
 
-	\brief	Issue an AT command (to be used as debug as no command tracking is done)
-
-	This routine will send an out of band AT command to modem.
-
-	It could be used to debug/test modem.
+	\brief	Enable or disable transliteration of messages
 
-	Modem answer is ignored and discarded.
+	When enabled, characters outside default GSM-7 alphabet (like typographic quotes, dashes or some accented letters)
+		are replaced by close GSM-7 characters before sending, when this doesn't increase the count of SMS.
+		This is lossy, and disabled by default.
 
-	\param[in]	AT command to be send
+	\param[in]	enabled: true to enable transliteration, false to disable it
 	\return	none
 
 */
-void FF_A6lib::sendAT(const char *command) {
+void FF_A6lib::setTransliteration(const bool enabled) {
 	if (traceFlag) enterRoutine(__func__);
-	sendCommand(command);
-	inReceive = false;
+	transliterateFlag = enabled;
 }
 
 /*!
 
-	\brief	Issue an EOF command (to be used as debug as no command tracking is done)
-
-	This routine will send an EOF command to modem.
-
-	It could be used to debug/test modem.
-
-	Modem answer is ignored and discarded.
+	\brief	Return count of SMS saved by transliteration of last sent message
 
 	\param	none
-	\return	none
+	\return	Count of SMS saved by transliteration of last sent message
 
 */
-void FF_A6lib::sendEOF(void) {
-	if (traceFlag) enterRoutine(__func__);
-	sendCommand(0x1a);
-	inReceive = false;
+uint16_t FF_A6lib::getLastTransliterationSaving(void) {
+	return lastTransliterationSaving;
 }
 
 /*!
 
-	\brief	Check if modem shoudl be restarted
+	\brief	Set size of concatenated messages reference
 
-	This routine check if modem restart has been asked by code.
+	16 bits references (default) lower the risk of a handset merging unrelated messages, but cost one character per SMS.
 
-	\param	none
-	\return	true if modem should be restarted, false else
+	\param[in]	bits: reference size (8 or 16)
+	\return	none
 
 */
-bool FF_A6lib::needRestart(void){
-	if (traceFlag) enterRoutine(__func__);
-	return restartNeeded;
+void FF_A6lib::setConcatReferenceBits(const uint8_t bits) {
+	if (bits != 8 && bits != 16) {
+		trace_error_P("Reference size should be 8 or 16, not %d", bits);
+		return;
+	}
+	concatReference16 = (bits == 16);
 }
 
 /*!
 
-	\brief	Set the restart flag
+	\brief	Set file used to persist concatenated messages reference counter
 
-	This routine sets the restart required flag to a given value
+	References are reserved by blocks of A6_REFERENCE_BLOCK, the end of last reserved block being saved in file.
+		This way, references are not reused after a reboot, with only one write per block.
 
-	\param[in]	value to be set (true or false)
-	\return	none
+	\param[in]	fs: file system to use (LittleFS, SPIFFS...)
+	\param[in]	path: file path (up to A6_REFERENCE_PATH_LEN - 1 characters)
+	\return	true if counter has been loaded (or file doesn't exist yet), false else
 
 */
-void FF_A6lib::setRestart(bool restartFlag){
+bool FF_A6lib::setReferenceStore(FS& fs, const char* path) {
 	if (traceFlag) enterRoutine(__func__);
-	restartNeeded = restartFlag;
+	if (strlen(path) >= sizeof(referenceFile)) {
+		trace_error_P("Reference file name too long: %s", path);
+		return false;
+	}
+	referenceFs = &fs;
+	strncpy(referenceFile, path, sizeof(referenceFile));
+	memset(referenceTable, 0, sizeof(referenceTable));	// Forget blocks reserved before
+	if (!fs.exists(path)) {
+		return true;
+	}
+	File file = fs.open(path, "r");
+	uint8_t buffer[2];
+	if (!file || file.read(buffer, sizeof(buffer)) != sizeof(buffer)) {
+		trace_error_P("Can't read %s", path);
+		if (file) file.close();
+		return false;
+	}
+	file.close();
+	referenceCounter = buffer[0] | (buffer[1] << 8);
+	if (debugFlag) trace_info_P("Loaded reference counter %d from %s", referenceCounter, path);
+	return true;
 }
 
 /*!
 
-	\brief	Checks if modem is idle
+	\brief	Set file used to persist SCA (service center) numbers
 
-	This routine checks if modem is idle (not initializing, sending nor receiving)
+	SCA numbers of last used SIM cards are saved, keyed by SIM card identifier (ICCID).
+		At next start, when SIM card is known, saved SCA is used instead of asking modem (AT+CSCA?),
+		and checked in background once modem is idle.
 
-	\param	none
-	\return	true if modem is idle, false else
+	\param[in]	fs: file system to use (LittleFS, SPIFFS...)
+	\param[in]	path: file path (up to A6_SCA_PATH_LEN - 1 characters)
+	\return	true if file name has been accepted, false else
 
 */
-bool FF_A6lib::isIdle(void){
+bool FF_A6lib::setScaStore(FS& fs, const char* path) {
 	if (traceFlag) enterRoutine(__func__);
-	return (gsmIdle == A6_IDLE);
+	if (strlen(path) >= sizeof(scaFile)) {
+		trace_error_P("SCA file name too long: %s", path);
+		return false;
+	}
+	scaFs = &fs;
+	strncpy(scaFile, path, sizeof(scaFile));
+	return true;
 }
 
 /*!
 
-	\brief	Checks if modem is sending something
-
-	This routine checks if modem is sending something (either commands or messages)
+	\brief	[Private] Return length of concatenated message information element
 
 	\param	none
-	\return	true is modem is sending, false else
+	\return	Length of information element, depending on reference size
 
 */
-bool FF_A6lib::isSending(void){
-	if (traceFlag) enterRoutine(__func__);
-	return (gsmIdle == A6_SEND);
+uint8_t FF_A6lib::concatUdhLen(void) {
+	uint8_t udh[6];
+	return FF_A6pdu::buildConcatUdh(udh, 0, 0, 0, concatReference16);
 }
 
 /*!
 
-	\brief	Checks if modem is receiving
+	\brief	[Private] Allocate a concatenated message reference for a destination
 
-	This routine checks if modem is receiving a SMS
+	Each recent destination gets consecutive references from its own block, so that a handset sees as many
+		different references as possible before one is reused. Least recently used destination is forgotten when table is full.
 
-	\param	none
-	\return	true if a SMS is receiving, false else
+	\param[in]	number: destination phone number
+	\return	Reference to use (8 or 16 bits, depending on setConcatReferenceBits)
 
 */
-bool FF_A6lib::isReceiving(void){
-	if (traceFlag) enterRoutine(__func__);
-	return (gsmIdle == A6_RECV);
+uint16_t FF_A6lib::nextConcatReference(const char* number) {
+	uint32_t hash = fnvHash(number, strlen(number));
+	uint32_t now = millis();
+	A6referenceEntry* entry = NULL;
+	A6referenceEntry* oldest = NULL;
+	uint32_t oldestAge = 0;
+	for (uint8_t i = 0; i < A6_REFERENCE_DESTINATIONS; i++) {
+		if (referenceTable[i].numberHash == hash && referenceTable[i].lastUse) {
+			entry = &referenceTable[i];
+			break;
+		}
+		// Compare ages rather than times, to stay right when millis() wraps (unused entries being the oldest)
+		uint32_t age = referenceTable[i].lastUse ? now - referenceTable[i].lastUse : UINT32_MAX;
+		if (!oldest || age > oldestAge) {
+			oldest = &referenceTable[i];
+			oldestAge = age;
+		}
+	}
+	if (!entry) {											// New destination, reuse oldest entry
+		entry = oldest;
+		entry->numberHash = hash;
+		entry->left = 0;
+	}
+	if (!entry->left) {										// Block exhausted, reserve a new one
+		entry->next = reserveReferences();
+		entry->left = A6_REFERENCE_BLOCK;
+	}
+	entry->lastUse = now | 1;								// Never 0, as 0 means unused
+	entry->left--;
+	return (entry->next++) & (concatReference16 ? 0xffff : 0xff);
 }
 
 /*!
 
-	\brief	[Private] Modem initialization: open modem at a given speed
+	\brief	[Private] Reserve a block of concatenated message references
 
-	\param[in]	baudRate: speed (in bds) to use to open modem
-	\return	none
+	\param	none
+	\return	First reference of block
 
 */
-void FF_A6lib::openModem(long baudRate) {
-	if (traceFlag) enterRoutine(__func__);
-		if (debugFlag) trace_debug_P("Opening modem at %d bds", baudRate);
-        #ifdef USE_SOFTSERIAL_FOR_A6LIB
-            // Open modem at given speed
-        a6Serial.begin(baudRate, SWSERIAL_8N1, modemTxPin, modemRxPin, false, MAX_SMS_NUMBER_LEN + 3);	// Connect to Serial Software
-            // Enable TX interruption for speeds up to 19200 bds
-            a6Serial.enableIntTx((baudRate <= 19200));
-        #else
-            a6Serial.begin(baudRate, SERIAL_8N1);
-            #ifndef USE_DIRECT_CONNECTIONS_FOR_A6LIB
-            a6Serial.setDebugOutput(false);
-                a6Serial.swap();
-            #endif
-        #endif
-        // Flush pending input chars
-        while (a6Serial.available()) {
-			a6Serial.read();
-        }
+uint16_t FF_A6lib::reserveReferences(void) {
+	uint16_t first = referenceCounter;
+	referenceCounter += A6_REFERENCE_BLOCK;
+	if (referenceFs) {
+		uint8_t buffer[2] = {(uint8_t) (referenceCounter & 0xff), (uint8_t) (referenceCounter >> 8)};
+		File file = referenceFs->open(referenceFile, "w");
+		if (!file || file.write(buffer, sizeof(buffer)) != sizeof(buffer)) {
+			trace_error_P("Can't write %s", referenceFile);
+		}
+		if (file) file.close();
+	}
+	return first;
 }
 
 /*!
 
-	\brief	Return restart reason
+	\brief	[Private] Compute FNV-1a hash of some data
 
-	\param	none
-	\return	restart reason
+	\param[in]	data: data to hash
+	\param[in]	len: data length
+	\param[in]	hash: initial value (to chain several calls)
+	\return	Hash value
 
 */
-int FF_A6lib::getRestartReason(void) {
-    return restartReason;
+uint32_t FF_A6lib::fnvHash(const void* data, const size_t len, uint32_t hash) {
+	const uint8_t* ptr = (const uint8_t*) data;
+	for (size_t i = 0; i < len; i++) {
+		hash = (hash ^ ptr[i]) * 16777619UL;
+	}
+	return hash;
 }
 
 /*!
 
-	\brief	[Private] Modem initialization: reset modem to factory defaults
+	\brief	Sends a message built from a compile-time template
 
-	\param	none
-	\return	none
+	This routine sends a template (see FF_A6template), replacing its placeholders by given fields.
+		Static parts having been encoded at compile time, only fields are encoded here, and spliced with static parts into a single SMS.
+		When a field doesn't fit in template alphabet, or when message needs more than one SMS, full message is sent as sendSMS does.
+
+	\param[in]	number: phone number to send message to
+	\param[in]	tpl: template view (as given by FF_A6template::view)
+	\param[in]	fields: fields to put in place of placeholders (NULL fields are considered as empty)
+	\param[in]	fieldCount: count of fields
+	\return	none
+
+*/
+void FF_A6lib::sendTemplate(const char* number, const A6templateView& tpl, const char* const* fields, const uint8_t fieldCount) {
+	if (traceFlag) enterRoutine(__func__);
+	A6_HEAP_PROBE(A6_HEAP_SEND_TEMPLATE);
+	if (!destinationAllowed(number) || !setDestination(number)) return;
+	// Number and fields taken from sent history would be overwritten by this new message, copy them first
+	char numberCopy[A6_PDU_MAX_NUMBER];
+	if (sentHistory.owns(number)) {
+		strncpy(numberCopy, number, sizeof(numberCopy) - 1);
+		numberCopy[sizeof(numberCopy) - 1] = 0;
+		number = numberCopy;
+	}
+	const char* safeFields[A6_TEMPLATE_MAX_FIELDS];
+	uint16_t copiedLength = 0;
+	for (uint8_t i = 0; i < tpl.fieldCount; i++) {
+		safeFields[i] = (i < fieldCount) ? fields[i] : NULL;
+		if (safeFields[i] && sentHistory.owns(safeFields[i])) {
+			uint16_t fieldLength = strlen(safeFields[i]);
+			if (copiedLength + fieldLength >= sizeof(textBuffer)) {
+				trace_error_P("Fields too long to be resent (%d bytes)", copiedLength + fieldLength);
+				return;
+			}
+			memcpy(textBuffer + copiedLength, safeFields[i], fieldLength + 1);
+			safeFields[i] = textBuffer + copiedLength;
+			copiedLength += fieldLength + 1;
+		}
+	}
+	uint8_t userData[(A6_PDU_MAX_UD * 8) / 7];
+	uint16_t capacity = (tpl.dcs == A6_DCS_GSM7) ? FF_A6pdu::udCapacity(A6_DCS_GSM7, 0) : FF_A6pdu::udCapacity(A6_DCS_UCS2, 0) * 2;
+	uint16_t userDataLen = 0;
+	bool fits = true;
+
+	// Splice precomputed static parts and run time encoded fields
+	for (uint8_t i = 0; i <= tpl.fieldCount && fits; i++) {
+		if (userDataLen + tpl.partLength[i] > capacity) {
+			fits = false;
+			break;
+		}
+		memcpy(userData + userDataLen, tpl.encoded + tpl.partOffset[i], tpl.partLength[i]);
+		userDataLen += tpl.partLength[i];
+		if (i < tpl.fieldCount && safeFields[i] && safeFields[i][0]) {
+			uint16_t fieldLength = strlen(safeFields[i]);
+			uint16_t encodedLength;
+			if (tpl.dcs == A6_DCS_GSM7) {
+				encodedLength = FF_A6text::gsm7Encode(safeFields[i], 0, fieldLength, userData + userDataLen, capacity - userDataLen, A6_LANG_DEFAULT, A6_LANG_DEFAULT);
+			} else {
+				encodedLength = FF_A6text::utf16Encode(safeFields[i], 0, fieldLength, userData + userDataLen, capacity - userDataLen);
+			}
+			fits = (encodedLength != 0);					// Field doesn't fit in alphabet or in remaining space
+			userDataLen += encodedLength;
+		}
+	}
+
+	// Rebuild full message directly in history
+	uint16_t messageLength = 0;
+	for (uint8_t i = 0; i <= tpl.fieldCount; i++) {
+		messageLength += tpl.textLength[i];
+		if (i < tpl.fieldCount && safeFields[i]) {
+			messageLength += strlen(safeFields[i]);
+		}
+	}
+	char* message = sentHistory.add(getEpoch(), number, NULL, messageLength);
+	if (!message) {
+		trace_error_P("Message too long (%d bytes)", messageLength);
+		return;
+	}
+	char* ptr = message;
+	for (uint8_t i = 0; i <= tpl.fieldCount; i++) {
+		memcpy(ptr, tpl.text + tpl.textOffset[i], tpl.textLength[i]);
+		ptr += tpl.textLength[i];
+		if (i < tpl.fieldCount && safeFields[i]) {
+			memcpy(ptr, safeFields[i], strlen(safeFields[i]));
+			ptr += strlen(safeFields[i]);
+		}
+	}
+	if (!fits) {											// Use standard path
+		if (debugFlag) trace_debug_P("Template doesn't fit in one SMS, using standard path", NULL);
+		uint16_t segments = selectAlphabet(message, messageLength);
+		if (segments > 255) {								// Chunk count and index are sent on 8 bits
+			trace_error_P("Message too long (%d SMS)", segments);
+			return;
+		}
+		sendSavedMessage(number, message, messageLength, segments, NULL);
+		return;
+	}
+	lastTransliterationSaving = 0;
+	smsDcs = tpl.dcs;
+	smsLockingShift = A6_LANG_DEFAULT;
+	smsSingleShift = A6_LANG_DEFAULT;
+	smsMsgCount = 0;
+	smsMsgIndex = 0;
+	int len = a6Pdu.encodeSubmit(smsAddress, tpl.dcs, NULL, 0, userData, userDataLen);
+	if (len < 0)  {
+		trace_error_P("Encode error %d sending SMS to %s >%s<", len, number, message);
+		return;
+	}
+	if (debugFlag) trace_debug_P("Sending SMS to %s >%s<", number, message);
+	sendPdu(len, a6Pdu.getPdu());
+}
+
+/*!
+
+	\brief	Sends binary data as 8 bits SMS
+
+	This routine sends raw bytes (data coding scheme 0x04), without any text analysis.
+		Data longer than one SMS (140 bytes, less header) is split in multi-part SMS. Data is copied, so caller buffer may be reused at once.
+
+	\param[in]	number: phone number to send data to
+	\param[in]	data: data to send
+	\param[in]	len: data length (up to A6_MAX_BINARY_LEN bytes)
+	\param[in]	destinationPort: destination application port (no application port addressing if both ports are zero)
+	\param[in]	sourcePort: source application port
+	\return	none
+
+*/
+void FF_A6lib::sendBinary(const char* number, const uint8_t* data, const uint16_t len, const uint16_t destinationPort, const uint16_t sourcePort) {
+	if (traceFlag) enterRoutine(__func__);
+	A6_HEAP_PROBE(A6_HEAP_SEND_BINARY);
+	if (len > sizeof(binaryData)) {
+		trace_error_P("Binary data too long (%d bytes)", len);
+		return;
+	}
+	memcpy(binaryData, data, len);
+	sendBinaryBuffer(number, len, destinationPort, sourcePort, NULL);
+}
+
+/*!
+
+	\brief	Sends a text message compressed with a static dictionary
+
+	Message is compressed by FF_A6compress and sent as 8 bits SMS on A6_COMPRESS_PORT, to be decompressed by a FF_A6lib peer.
+		If compression doesn't save at least one SMS, message is sent as a normal text SMS.
+
+	\param[in]	number: phone number to send message to
+	\param[in]	text: message to send (UTF-8)
+	\return	none
+
+*/
+void FF_A6lib::sendCompressed(const char* number, const char* text) {
+	if (traceFlag) enterRoutine(__func__);
+	A6_HEAP_PROBE(A6_HEAP_SEND_COMPRESSED);
+	uint16_t textLen = strlen(text);
+	uint16_t len = FF_A6compress::compress(text, textLen, binaryData, sizeof(binaryData));
+	if (len) {
+		uint8_t udh[6];
+		uint8_t portUdhLen = FF_A6pdu::buildPortUdh(udh, A6_COMPRESS_PORT, A6_COMPRESS_PORT);
+		uint16_t segments = 1;
+		if (len > FF_A6pdu::udCapacity(A6_DCS_8BIT, portUdhLen)) {
+			uint16_t chunkSize = FF_A6pdu::udCapacity(A6_DCS_8BIT, concatUdhLen() + portUdhLen);
+			segments = (len + chunkSize - 1) / chunkSize;
+		}
+		A6messagePlan plan = planMessage(text);
+		if (segments < plan.segmentCount) {
+			if (debugFlag) trace_info_P("Compressed %d bytes into %d, %d SMS instead of %d", textLen, len, segments, plan.segmentCount);
+			sendBinaryBuffer(number, len, A6_COMPRESS_PORT, A6_COMPRESS_PORT, text);
+			return;
+		}
+	}
+	if (debugFlag) trace_info_P("Compression doesn't save any SMS, sending text", NULL);
+	sendSMS(number, text);
+}
+
+/*!
+
+	\brief	Queue a text message, to be sent as soon as modem is idle
+
+	Queued messages are sent by doLoop, in order, without caller having to wait for modem being idle.
+
+	\param[in]	number: phone number to send message to
+	\param[in]	text: message to send (UTF-8)
+	\return	true if message has been queued, false if queue is full
+
+*/
+bool FF_A6lib::queueSMS(const char* number, const char* text) {
+	if (traceFlag) enterRoutine(__func__);
+	return queuePush(A6_QUEUE_TEXT, number, (const uint8_t*) text, strlen(text) + 1, 0, 0);
+}
+
+/*!
+
+	\brief	Queue binary data, to be sent as 8 bits SMS as soon as modem is idle
+
+	\param[in]	number: phone number to send data to
+	\param[in]	data: data to send
+	\param[in]	len: data length (up to A6_MAX_BINARY_LEN bytes)
+	\param[in]	destinationPort: destination application port (no application port addressing if both ports are zero)
+	\param[in]	sourcePort: source application port
+	\return	true if data has been queued, false if queue is full
+
+*/
+bool FF_A6lib::queueBinary(const char* number, const uint8_t* data, const uint16_t len, const uint16_t destinationPort, const uint16_t sourcePort) {
+	if (traceFlag) enterRoutine(__func__);
+	if (len > sizeof(binaryData)) {
+		trace_error_P("Binary data too long (%d bytes)", len);
+		return false;
+	}
+	return queuePush(A6_QUEUE_BINARY, number, data, len, destinationPort, sourcePort);
+}
+
+/*!
+
+	\brief	Queue a text message, to be sent compressed (see sendCompressed) as soon as modem is idle
+
+	\param[in]	number: phone number to send message to
+	\param[in]	text: message to send (UTF-8)
+	\return	true if message has been queued, false if queue is full
+
+*/
+bool FF_A6lib::queueCompressed(const char* number, const char* text) {
+	if (traceFlag) enterRoutine(__func__);
+	return queuePush(A6_QUEUE_COMPRESSED, number, (const uint8_t*) text, strlen(text) + 1, 0, 0);
+}
+
+/*!
+
+	\brief	Returns count of queued messages
+
+	\param	none
+	\return	Count of messages waiting to be sent
+
+*/
+uint16_t FF_A6lib::getQueueCount(void) {
+	return queueCount;
+}
+
+/*!
+
+	\brief	Returns performance counters
+
+	Counters give boot to ready time of last begin, and time spent sending messages and chunks (from AT+CMGS to modem acknowledge).
+		They may be used to compare library versions or modem settings on real hardware.
+
+	\param	none
+	\return	Performance counters
+
+*/
+const A6perfStats& FF_A6lib::getPerfStats(void) {
+	return perfStats;
+}
+
+/*!
+
+	\brief	Reset performance counters (except boot time)
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6lib::resetPerfStats(void) {
+	unsigned long bootTime = perfStats.bootTime;
+	memset(&perfStats, 0, sizeof(perfStats));
+	perfStats.bootTime = bootTime;
+}
+
+/*!
+
+	\brief	Set modem power control
+
+	\param[in]	driver: power driver used by recover() (NULL to only initialize modem again)
+	\return	none
+
+*/
+void FF_A6lib::setPowerDriver(FF_A6powerDriver* driver) {
+	powerDriver = driver;
+}
+
+/*!
+
+	\brief	Recover a hung modem (to be called instead of begin when needRestart() is true)
+
+	First call initializes modem again, as begin does. If this fails, doLoop pulses reset line,
+		then switches modem off and on with power key (when power driver can drive them), without waiting for another call.
+		Reset pulse and power cycle run asynchronously in doLoop, followed by a new initialization.
+		Once strongest method failed, needRestart() is true again, and next call retries it.
+
+		As power key toggles modem power, modem is only switched on when power driver status tells it's off.
+			Without status, modem is asked for an AT answer after power key was pressed once, and only pressed again if it doesn't answer.
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6lib::recover(void) {
+	if (traceFlag) enterRoutine(__func__);
+	if (recoveryMethod != A6_RECOVER_NONE && recoveryAttempts < 255) {	// Previous recovery failed, escalate
+		recoveryAttempts++;
+	}
+	uint8_t method = recoveryMethodAt(recoveryAttempts);
+	recoveryMethod = method;
+	recoveryStartTime = millis();
+	recoveryStats[method].count++;
+	trace_warn_P("Recovering modem with method %d, attempt %d", method, recoveryAttempts + 1);
+	if (method == A6_RECOVER_SOFT) {
+		begin(modemBaudRate, modemRxPin, modemTxPin);
+		return;
+	}
+	restartNeeded = false;
+	inReceive = false;
+	inWait = false;
+	smsReady = false;										// Wait for a new "SMS Ready"
+	gsmIdle = A6_STARTING;
+	powerStepTime = millis();
+	if (method == A6_RECOVER_RESET) {
+		powerDriver->setReset(true);
+		powerState = A6_POWER_RESETTING;
+	} else if (powerDriver->hasStatus() && !powerDriver->isPoweredOn()) {
+		powerDriver->setPowerKey(true);						// Modem is already off, just switch it on
+		powerState = A6_POWER_ON;
+	} else {
+		powerDriver->setPowerKey(true);						// Power key toggles modem power: switch it off first
+		powerState = A6_POWER_OFF;
+	}
+}
+
+/*!
+
+	\brief	[Private] Return recovery method to use after some failed recoveries
+
+	\param[in]	attempts: count of failed recoveries
+	\return	Recovery method, depending on lines power driver can drive
+
+*/
+uint8_t FF_A6lib::recoveryMethodAt(const uint8_t attempts) {
+	uint8_t method = A6_RECOVER_SOFT;
+	if (powerDriver) {
+		bool canReset = powerDriver->hasReset();
+		if (canReset && attempts >= 1) {
+			method = A6_RECOVER_RESET;
+		}
+		if (powerDriver->hasPowerKey() && attempts >= (canReset ? 2 : 1)) {
+			method = A6_RECOVER_POWER;
+		}
+	}
+	return method;
+}
+
+/*!
+
+	\brief	Return counters of a recovery method
+
+	\param[in]	method: recovery method (A6_RECOVER_SOFT, A6_RECOVER_RESET or A6_RECOVER_POWER)
+	\return	Counters of this method
+
+*/
+const A6recoveryStats& FF_A6lib::getRecoveryStats(const uint8_t method) {
+	return recoveryStats[method < A6_RECOVER_METHODS ? method : 0];
+}
+
+/*!
+
+	\brief	[Private] Run next step of reset pulse or power cycle, when its time has come
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6lib::powerStep(void) {
+	unsigned long elapsed = millis() - powerStepTime;
+	uint8_t nextState = powerState;
+	if (powerState == A6_POWER_RESETTING) {
+		if (elapsed >= powerDriver->resetPulse) {
+			powerDriver->setReset(false);
+			nextState = A6_POWER_BOOTING;
+		}
+	} else if (powerState == A6_POWER_OFF) {
+		if (elapsed >= powerDriver->powerKeyPulse) {
+			powerDriver->setPowerKey(false);
+			nextState = A6_POWER_OFF_WAITING;
+		}
+	} else if (powerState == A6_POWER_OFF_WAITING) {
+		if (elapsed >= powerDriver->powerOffWait) {
+			if (!powerDriver->hasStatus()) {				// Ask modem, as power key switched it on if it was off
+				nextState = A6_POWER_PROBING;
+				sendCommand("AT", &FF_A6lib::gotPowerProbe, DEFAULT_ANSWER, powerDriver->bootWait);
+				gsmTimeout = powerDriver->bootWait;			// Modem may be booting, don't use adaptive timeout
+				latencySlot = A6_LATENCY_NONE;
+				backgroundCheck = true;
+			} else if (powerDriver->isPoweredOn()) {		// Power key switched modem on, it was off
+				nextState = A6_POWER_BOOTING;
+			} else {
+				powerDriver->setPowerKey(true);
+				nextState = A6_POWER_ON;
+			}
+		}
+	} else if (powerState == A6_POWER_ON) {
+		if (elapsed >= powerDriver->powerKeyPulse) {
+			powerDriver->setPowerKey(false);
+			nextState = A6_POWER_BOOTING;
+		}
+	} else if (elapsed >= powerDriver->bootWait) {			// Modem booted, initialize it
+		powerState = A6_POWER_IDLE;
+		begin(modemBaudRate, modemRxPin, modemTxPin);
+		return;
+	}
+	if (nextState != powerState) {
+		if (debugFlag) trace_debug_P("Power step %d after %d ms", nextState, elapsed);
+		powerState = nextState;
+		powerStepTime = millis();
+	}
+}
+
+/*!
+
+	\brief	[Private] Continue power cycle depending on modem answer to AT, after power key was pressed once
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6lib::gotPowerProbe(void) {
+	if (traceFlag) enterRoutine(__func__);
+	inReceive = false;
+	if (gsmStatus == A6_OK) {								// Modem answers, power key switched it on as it was off
+		if (debugFlag) trace_debug_P("Modem answers after power key, initializing it", NULL);
+		powerState = A6_POWER_IDLE;
+		begin(modemBaudRate, modemRxPin, modemTxPin);
+		return;
+	}
+	if (debugFlag) trace_debug_P("Modem is off, switching it on", NULL);
+	powerDriver->setPowerKey(true);
+	powerState = A6_POWER_ON;
+	powerStepTime = millis();
+}
+
+/*!
+
+	\brief	Set idle heartbeat
+
+	When enabled, an "AT" command is sent after modem has been idle for a while (only when no message is queued).
+		Interval is shortened when heartbeats are missed (halved for each failure in last 8 heartbeats, down to
+		A6_HEARTBEAT_MIN_INTERVAL), and a restart is asked after A6_HEARTBEAT_MAX_MISSES consecutive misses.
+
+	\param[in]	interval: longest interval between heartbeats (s, 0 to disable)
+	\return	none
+
+*/
+void FF_A6lib::setHeartbeat(const uint16_t interval) {
+	heartbeatInterval = interval;
+	heartbeatTime = millis();
+}
+
+/*!
+
+	\brief	[Private] Send heartbeat command
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6lib::heartbeat(void) {
+	if (traceFlag) enterRoutine(__func__);
+	heartbeatCount++;
+	gsmIdle = A6_CHECK;
+	sendCommand("AT", &FF_A6lib::gotHeartbeat, DEFAULT_ANSWER, A6_HEARTBEAT_TIMEOUT);
+	backgroundCheck = true;
+}
+
+/*!
+
+	\brief	[Private] Check heartbeat answer, asking for a restart after too many misses
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6lib::gotHeartbeat(void) {
+	if (traceFlag) enterRoutine(__func__);
+	bool alive = (gsmStatus == A6_OK);						// Else, error or time out
+	heartbeatHistory = (heartbeatHistory << 1) | (alive ? 0 : 1);
+	if (alive) {
+		heartbeatMisses = 0;
+	} else {
+		heartbeatFailCount++;
+		heartbeatMisses++;
+		trace_warn_P("Missed heartbeat %d of %d", heartbeatMisses, A6_HEARTBEAT_MAX_MISSES);
+		if (heartbeatMisses >= A6_HEARTBEAT_MAX_MISSES) {
+			trace_error_P("Modem doesn't answer anymore", NULL);
+			heartbeatMisses = 0;
+			gsmStatus = A6_TIMEOUT;
+			restartReason = gsmStatus;
+			restartNeeded = true;
+		}
+	}
+	setIdle();
+}
+
+/*!
+
+	\brief	[Private] Return delay before next heartbeat
+
+	\param	none
+	\return	Delay (ms), depending on recent failures
+
+*/
+unsigned long FF_A6lib::heartbeatDelay(void) {
+	uint8_t failures = 0;
+	for (uint8_t history = heartbeatHistory; history; history >>= 1) {
+		failures += history & 1;
+	}
+	uint16_t interval = heartbeatMisses ? A6_HEARTBEAT_MIN_INTERVAL : heartbeatInterval >> failures;
+	if (interval < A6_HEARTBEAT_MIN_INTERVAL) interval = A6_HEARTBEAT_MIN_INTERVAL;
+	return interval * 1000UL;
+}
+
+/*!
+
+	\brief	Derive command timeouts from observed latency
+
+	Latency of each command (up to "=" or "?") is tracked as a smoothed average and mean deviation.
+		Once A6_LATENCY_MIN_SAMPLES answers have been seen, command timeout becomes average + 4 * deviation + A6_LATENCY_MARGIN,
+		bounded by floor and ceiling. A time out counts as a sample of timeout length, so repeated time outs raise timeout.
+
+	\param[in]	floor: shortest timeout (ms)
+	\param[in]	ceiling: longest timeout (ms, 0 to use fixed timeouts)
+	\return	none
+
+*/
+void FF_A6lib::setAdaptiveTimeouts(const unsigned long floor, const unsigned long ceiling) {
+	timeoutFloor = floor;
+	timeoutCeiling = ceiling;
+}
+
+/*!
+
+	\brief	Return observed latency of a command
+
+	\param[in]	slot: latency slot (0 to A6_LATENCY_SLOTS - 1, unused slots have an empty command)
+	\return	Observed latency
+
+*/
+const A6latency& FF_A6lib::getLatency(const uint8_t slot) {
+	return latencies[slot < A6_LATENCY_SLOTS ? slot : 0];
+}
+
+/*!
+
+	\brief	[Private] Select latency slot of a command, and return its timeout
+
+	When table is full, least sampled command is replaced.
+
+	\param[in]	command: command to send (empty to wait for answer of previous command)
+	\param[in]	defaultTimeout: fixed timeout of this command (ms)
+	\return	Timeout to use (ms)
+
+*/
+unsigned long FF_A6lib::commandTimeout(const char* command, const unsigned long defaultTimeout) {
+	char name[A6_LATENCY_COMMAND_LEN];
+	uint8_t len = 0;
+	while (command[len] && command[len] != '=' && command[len] != '?' && len < sizeof(name) - 1) {
+		name[len] = command[len];
+		len++;
+	}
+	name[len] = 0;
+	latencySlot = A6_LATENCY_NONE;
+	if (!len) {
+		return defaultTimeout;
+	}
+	uint8_t leastUsed = 0;
+	for (uint8_t i = 0; i < A6_LATENCY_SLOTS; i++) {
+		if (!strcmp(latencies[i].command, name)) {
+			latencySlot = i;
+			break;
+		}
+		if (!latencies[leastUsed].command[0]) continue;		// Free slot already found
+		if (!latencies[i].command[0] || latencies[i].count < latencies[leastUsed].count) leastUsed = i;
+	}
+	if (latencySlot == A6_LATENCY_NONE) {					// New command
+		latencySlot = leastUsed;
+		memset(&latencies[latencySlot], 0, sizeof(A6latency));
+		strncpy(latencies[latencySlot].command, name, sizeof(latencies[latencySlot].command));
+	}
+	A6latency& latency = latencies[latencySlot];
+	if (!timeoutCeiling || latency.count < A6_LATENCY_MIN_SAMPLES) {
+		return defaultTimeout;
+	}
+	unsigned long timeout = latency.average + 4UL * latency.deviation + A6_LATENCY_MARGIN;
+	if (timeout < timeoutFloor) timeout = timeoutFloor;
+	if (timeout > timeoutCeiling) timeout = timeoutCeiling;
+	return timeout;
+}
+
+/*!
+
+	\brief	[Private] Record answer latency of running command
+
+	\param[in]	latency: time between command and answer (ms)
+	\return	none
+
+*/
+void FF_A6lib::recordLatency(const unsigned long latency) {
+	if (latencySlot == A6_LATENCY_NONE) {
+		return;
+	}
+	A6latency& entry = latencies[latencySlot];
+	long sample = (latency > 65535UL) ? 65535L : (long) latency;
+	if (!entry.count) {										// First sample
+		entry.average = sample;
+		entry.deviation = sample / 2;
+	} else {
+		long error = sample - entry.average;
+		entry.average += error / 8;
+		entry.deviation += ((error < 0 ? -error : error) - (long) entry.deviation) / 4;
+	}
+	if (entry.count < 65535) entry.count++;
+	latencySlot = A6_LATENCY_NONE;							// Only first answer counts
+}
+
+#ifdef FF_A6LIB_HEAP_STATS
+/*!
+
+	\brief	Returns heap accounting of an operation (only when FF_A6LIB_HEAP_STATS is defined)
+
+	Free heap is measured at entry and exit of each call. A steady state operation should have no growing calls.
+		On ESP8266 built with UMM_STATS_FULL, allocations are also counted, and peak usage comes from umm_malloc low-water mark,
+		showing memory allocated then freed during the call. Without it, allocation count stays at zero,
+		and peak usage only reflects heap retained at exit: this is not an allocation accounting.
+
+	\param[in]	operation: operation (A6_HEAP_SEND_SMS, A6_HEAP_SEND_BINARY...)
+	\return	Heap counters of operation
+
+*/
+const A6heapStats& FF_A6lib::getHeapStats(const uint8_t operation) {
+	return heapStats[operation < A6_HEAP_OPERATIONS ? operation : 0];
+}
+#endif
+
+/*!
+
+	\brief	Set router of received commands
+
+	Received text messages starting with a keyword known by router are given to its handler, instead of SMS callbacks.
+
+	\param[in]	commandRouter: router to use (NULL to give all messages to SMS callbacks)
+	\return	none
+
+*/
+void FF_A6lib::setRouter(FF_A6router* commandRouter) {
+	router = commandRouter;
+}
+
+/*!
+
+	\brief	Set persistent log of messages
+
+	Sent messages are logged once fully sent, received ones when read. Log is written by doLoop when modem is idle.
+
+	\param[in]	log: log to use, already started (NULL to stop logging)
+	\return	none
+
+*/
+void FF_A6lib::setLog(FF_A6log* log) {
+	if (messageLog) messageLog->flush();
+	messageLog = log;
+}
+
+/*!
+
+	\brief	Set duplicate received messages window
+
+	A message received again (same sender, service center time stamp and content) within this window is dropped.
+		Only the last A6_DEDUP_SIZE messages are remembered.
+
+	\param[in]	seconds: window duration (0 to disable duplicate check)
+	\return	none
+
+*/
+void FF_A6lib::setDedupWindow(const uint16_t seconds) {
+	dedupWindow = seconds;
+}
+
+/*!
+
+	\brief	Set list of senders allowed to send messages
+
+	Messages from other senders are dropped before being decoded, without calling any callback.
+
+	\param[in]	numbers: set of allowed senders (NULL to allow everybody)
+	\return	none
+
+*/
+void FF_A6lib::setAllowList(FF_A6numberSet* numbers) {
+	allowList = numbers;
+}
+
+/*!
+
+	\brief	Set list of numbers messages should never be sent to (opted-out numbers)
+
+	Messages to these numbers are silently dropped before being encoded.
+
+	\param[in]	numbers: set of blocked destinations (NULL to send to everybody)
+	\return	none
+
+*/
+void FF_A6lib::setBlockList(FF_A6numberSet* numbers) {
+	blockList = numbers;
+}
+
+/*!
+
+	\brief	Set routine giving current time
+
+	Time source is called each time a timestamp is needed (for example, NtpClientLib/TimeLib now()).
+		It takes precedence over time set by setTime or read from modem.
+
+	\param[in]	timeSource: routine returning local time as count of seconds since 01/01/1970 (NULL to stop using it)
+	\return	none
+
+*/
+void FF_A6lib::setTimeSource(uint32_t (*timeSource)(void)) {
+	timeSourceCb = timeSource;
+}
+
+/*!
+
+	\brief	Set current time
+
+	Time is then maintained using millis().
+
+	\param[in]	epoch: local time as count of seconds since 01/01/1970
+	\return	none
+
+*/
+void FF_A6lib::setTime(const uint32_t epoch) {
+	clockBase = epoch;
+	clockBaseMillis = millis();
+}
+
+/*!
+
+	\brief	Set clock from modem network time at end of initialization
+
+	When enabled, modem is asked to set its clock from network (AT+CLTS=1), and its clock is read (AT+CCLK?) at each (re)start.
+		This is useful on nodes without any other time source.
+
+	\param[in]	enabled: true to use modem clock
+	\return	none
+
+*/
+void FF_A6lib::setModemClock(const bool enabled) {
+	modemClockFlag = enabled;
+}
+
+/*!
+
+	\brief	Let modem use its own SCA (service center) number
+
+	When enabled, PDUs are sent with an empty SMSC field (length 00), so modem uses its stored default,
+		saving up to 16 hex characters per chunk, and SCA is no longer asked to modem at (re)start.
+
+	\param[in]	enabled: true to use modem SCA
+	\return	none
+
+*/
+void FF_A6lib::setModemSca(const bool enabled) {
+	modemScaFlag = enabled;
+	a6Pdu.setScaNumber(enabled ? "" : currentSca);
+}
+
+/*!
+
+	\brief	Set time zone of gateway clock
+
+	Time zone is used to convert service center time stamps into gateway local time. It's set automatically when modem clock is used.
+
+	\param[in]	minutes: time zone (minutes east of UTC)
+	\return	none
+
+*/
+void FF_A6lib::setTimeZone(const int16_t minutes) {
+	timeZone = minutes;
+}
+
+/*!
+
+	\brief	Returns histogram of delays between service center and gateway
+
+	Buckets are: less than 10s, 30s, 1mn, 2mn, 5mn, 15mn, 1h, and 1h or more.
+		Messages received while gateway time is not known are not accounted (see getDelayUnknownCount).
+
+	\param	none
+	\return	Array of A6_DELAY_BUCKETS counters
+
+*/
+const unsigned long* FF_A6lib::getDelayHistogram(void) {
+	return delayHistogram;
+}
+
+/*!
+
+	\brief	Returns count of received messages whose delay can't be computed
+
+	\param	none
+	\return	Count of messages
+
+*/
+unsigned long FF_A6lib::getDelayUnknownCount(void) {
+	return delayUnknownCount;
+}
+
+/*!
+
+	\brief	Returns current time
+
+	\param	none
+	\return	Local time as count of seconds since 01/01/1970 (seconds since boot, plus one, if time is not known)
+
+*/
+uint32_t FF_A6lib::getEpoch(void) {
+	if (timeSourceCb) {
+		return (*timeSourceCb)();
+	}
+	unsigned long elapsed = millis() - clockBaseMillis;
+	if (elapsed >= 3600000UL) {								// Move base forward, to stay away from millis() wrap
+		clockBase += elapsed / 1000;
+		clockBaseMillis += (elapsed / 1000) * 1000;
+		elapsed %= 1000;
+	}
+	return clockBase ? clockBase + elapsed / 1000 : millis() / 1000 + 1;
+}
+
+/*!
+
+	\brief	[Private] Add a record to outbound queue
+
+	Records are stored contiguously in a ring arena: an 8 bytes header (type, address length, data length, ports),
+		followed by number (packed as a PDU destination address, see FF_A6pdu::encodeNumber) and data. When a record doesn't fit at end of arena, a wrap marker is written and record starts at arena beginning.
+
+	\param[in]	type: record type (A6_QUEUE_TEXT, A6_QUEUE_BINARY or A6_QUEUE_COMPRESSED)
+	\param[in]	number: phone number
+	\param[in]	data: data to queue (including final zero for texts)
+	\param[in]	len: data length
+	\param[in]	destinationPort: destination application port
+	\param[in]	sourcePort: source application port
+	\return	true if record has been queued, false if queue is full
+
+*/
+bool FF_A6lib::queuePush(const uint8_t type, const char* number, const uint8_t* data, const uint16_t len, const uint16_t destinationPort, const uint16_t sourcePort) {
+	uint8_t address[A6_PDU_ADDRESS_LEN];
+	uint8_t addressLen = FF_A6pdu::encodeNumber(number, address);	// Keep number packed, as in PDU
+	uint16_t recordLen = A6_QUEUE_HEADER_LEN + addressLen + len;
+	uint16_t pos;
+	if (!addressLen) {
+		trace_error_P("Bad number: %s", number);
+		return false;
+	}
+	if (!queueCount) {										// Empty queue, restart at beginning
+		queueHead = 0;
+		queueTail = 0;
+	}
+	if (queueCount && queueTail == queueHead) {				// Full queue
+		pos = A6_QUEUE_FULL;
+	} else if (queueTail >= queueHead) {					// Free space at end, and at beginning
+		if (sizeof(queueArena) - queueTail >= recordLen) {
+			pos = queueTail;
+		} else if (queueHead >= recordLen) {
+			if (queueTail < sizeof(queueArena)) queueArena[queueTail] = A6_QUEUE_WRAP;
+			pos = 0;
+		} else {
+			pos = A6_QUEUE_FULL;
+		}
+	} else {												// Free space between tail and head
+		pos = (queueHead - queueTail >= recordLen) ? queueTail : A6_QUEUE_FULL;
+	}
+	if (pos == A6_QUEUE_FULL) {
+		queueDroppedCount++;
+		trace_error_P("Queue full, can't queue %d bytes to %s", len, number);
+		return false;
+	}
+	uint8_t* record = queueArena + pos;
+	record[0] = type;
+	record[1] = addressLen;
+	record[2] = len & 0xff;
+	record[3] = len >> 8;
+	record[4] = destinationPort & 0xff;
+	record[5] = destinationPort >> 8;
+	record[6] = sourcePort & 0xff;
+	record[7] = sourcePort >> 8;
+	memcpy(record + A6_QUEUE_HEADER_LEN, address, addressLen);
+	memcpy(record + A6_QUEUE_HEADER_LEN + addressLen, data, len);
+	queueTail = pos + recordLen;
+	queueCount++;
+	if (debugFlag) trace_debug_P("Queued %d bytes to %s, %d message(s) in queue", len, number, queueCount);
+	return true;
+}
+
+/*!
+
+	\brief	[Private] Send first queued record
+
+	Number and data are given to send routines directly from arena, without intermediate copy.
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6lib::sendQueued(void) {
+	if (traceFlag) enterRoutine(__func__);
+	if (queueHead >= sizeof(queueArena) || queueArena[queueHead] == A6_QUEUE_WRAP) {
+		queueHead = 0;										// Record is at beginning of arena
+	}
+	const uint8_t* record = queueArena + queueHead;
+	uint8_t addressLen = record[1];
+	uint16_t len = record[2] | (record[3] << 8);
+	char number[A6_PDU_MAX_NUMBER];
+	FF_A6pdu::decodeNumber(record + A6_QUEUE_HEADER_LEN, number, sizeof(number));
+	const uint8_t* data = record + A6_QUEUE_HEADER_LEN + addressLen;
+	if (record[0] == A6_QUEUE_TEXT) {
+		sendSMS(number, (const char*) data);
+	} else if (record[0] == A6_QUEUE_COMPRESSED) {
+		sendCompressed(number, (const char*) data);
+	} else {
+		sendBinary(number, data, len, record[4] | (record[5] << 8), record[6] | (record[7] << 8));
+	}
+	// Data has been copied by send routines, so record can be freed
+	queueHead += A6_QUEUE_HEADER_LEN + addressLen + len;
+	queueCount--;
+}
+
+/*!
+
+	\brief	[Private] Sends binary data already copied in binaryData as 8 bits SMS
+
+	\param[in]	number: phone number to send data to
+	\param[in]	len: data length
+	\param[in]	destinationPort: destination application port (no application port addressing if both ports are zero)
+	\param[in]	sourcePort: source application port
+	\param[in]	message: message to save as last sent one (NULL to use data length)
+	\return	none
+
+*/
+void FF_A6lib::sendBinaryBuffer(const char* number, const uint16_t len, const uint16_t destinationPort, const uint16_t sourcePort, const char* message) {
+	char tempBuffer[30];
+	if (!destinationAllowed(number) || !setDestination(number)) return;
+	// Resending a message from history, copy it before it gets overwritten by this new message
+	char numberCopy[A6_PDU_MAX_NUMBER];
+	if (sentHistory.owns(number)) {
+		strncpy(numberCopy, number, sizeof(numberCopy) - 1);
+		numberCopy[sizeof(numberCopy) - 1] = 0;
+		number = numberCopy;
+	}
+	if (message && sentHistory.owns(message)) {
+		if (strlen(message) < sizeof(textBuffer)) {
+			strcpy(textBuffer, message);
+			message = textBuffer;
+		} else {											// Too long to be copied, save data length instead
+			message = NULL;
+		}
+	}
+	binaryLength = len;
+	binaryDestinationPort = destinationPort;
+	binarySourcePort = sourcePort;
+	uint8_t udh[6];
+	uint8_t portUdhLen = (destinationPort || sourcePort) ? FF_A6pdu::buildPortUdh(udh, destinationPort, sourcePort) : 0;
+	smsDcs = A6_DCS_8BIT;
+	if (len > FF_A6pdu::udCapacity(A6_DCS_8BIT, portUdhLen)) {	// This is a multi-part message
+		smsChunkSize = FF_A6pdu::udCapacity(A6_DCS_8BIT, concatUdhLen() + portUdhLen);
+		smsMsgCount = (len + smsChunkSize - 1) / smsChunkSize;
+		smsMsgId = nextConcatReference(number);
+	} else {
+		smsMsgCount = 0;
+	}
+	if (debugFlag) trace_info_P("8bit, length=%d, msgs=%d", len, smsMsgCount);
+	// Save last used number and message
+	snprintf_P(tempBuffer, sizeof(tempBuffer), PSTR("[%d bytes of data]"), len);
+	if (!message || !sentHistory.add(getEpoch(), number, message, strlen(message))) {
+		sentHistory.add(getEpoch(), number, tempBuffer, strlen(tempBuffer));
+	}
+	lastTransliterationSaving = 0;
+	// Send first (or only) SMS part
+	smsMsgIndex = 0;
+	smsChunkStart = 0;
+	if (smsMsgCount == 0) {
+		sendBinaryChunk(number, 0, len, 0, 0, 0);
+	} else {
+		sendNextSmsChunk();
+	}
+}
+
+/*!
+
+	\brief	[Private] Sends a binary SMS chunk to modem
+
+	\param[in]	number: phone number to send data to
+	\param[in]	startPos: chunk start position in binary data
+	\param[in]	endPos: chunk end position in binary data (excluded)
+	\param[in]	msgId: SMS message identifier (zero if not multi-part message)
+	\param[in]	msgCount: total number of SMS chunks (zero if not multi-part message)
+	\param[in]	msgIndex: index of this message chunk (zero if not multi-part message)
+	\return	none
+
+*/
+void FF_A6lib::sendBinaryChunk(const char* number, const uint16_t startPos, const uint16_t endPos, const unsigned short msgId, const unsigned char msgCount, const unsigned char msgIndex) {
+	if (traceFlag) enterRoutine(__func__);
+	uint8_t udh[12];
+	uint8_t udhLen = 0;
+	if (msgCount) {											// Add concatenation header to multi-part messages
+		udhLen = FF_A6pdu::buildConcatUdh(udh, msgId, msgCount, msgIndex, concatReference16);
+	}
+	if (binaryDestinationPort || binarySourcePort) {		// Add application port addressing
+		udhLen += FF_A6pdu::buildPortUdh(udh + udhLen, binaryDestinationPort, binarySourcePort);
+	}
+	int len = a6Pdu.encodeSubmit(smsAddress, A6_DCS_8BIT, udh, udhLen, binaryData + startPos, endPos - startPos);
+	if (len < 0)  {
+		trace_error_P("Encode error %d sending %d bytes to %s", len, endPos - startPos, number);
+		return;
+	}
+
+	if (debugFlag) trace_debug_P("Sending %d bytes to %s", endPos - startPos, number);
+	sendPdu(len, a6Pdu.getPdu());
+}
+
+/*!
+
+	\brief	Sends next SMS chunk to modem
+
+	This routine is called when an SMS chunk has been pushed to modem, to send next part, if it exists
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6lib::sendNextSmsChunk(void){
+	if (gsmIdle == A6_SEND) {								// Previous chunk has been acknowledged by modem
+		unsigned long chunkTime = millis() - chunkStartTime;
+		perfStats.chunkCount++;
+		perfStats.chunkTotalTime += chunkTime;
+		if (chunkTime > perfStats.chunkMaxTime) perfStats.chunkMaxTime = chunkTime;
+	}
+	if (smsMsgCount) {										// Are we in multi-part message ?
+		if (smsMsgIndex < smsMsgCount) {				// Do we have more chunks to send ?
+			A6historyEntry entry;
+			sentHistory.last(entry);						// Message being sent is the newest in history
+			uint16_t endPos;
+			if (smsDcs == A6_DCS_8BIT) {					// Binary message
+				endPos = smsChunkStart + smsChunkSize;
+				if (endPos > binaryLength) endPos = binaryLength;
+				sendBinaryChunk(entry.number, smsChunkStart, endPos, smsMsgId, smsMsgCount, ++smsMsgIndex);
+				smsChunkStart = endPos;
+				return;
+			}
+			// Chunk ends on a character boundary, never splitting an escape sequence or a surrogate pair
+			const char* text = entry.message;
+			uint16_t utf8Length = entry.length;
+			if (smsDcs == A6_DCS_GSM7) {
+				endPos = FF_A6text::gsm7ChunkEnd(text, utf8Length, smsChunkStart, smsChunkSize, smsLockingShift, smsSingleShift);
+			} else {
+				endPos = FF_A6text::utf16ChunkEnd(text, utf8Length, smsChunkStart, smsChunkSize);
+			}
+			sendTextChunk(entry.number, text, smsChunkStart, endPos, smsMsgId, smsMsgCount, ++smsMsgIndex);
+			smsChunkStart = endPos;
+			return;
+		}
+	}
+	if (messageInProgress) {
+		unsigned long messageTime = millis() - messageStartTime;
+		perfStats.messageCount++;
+		perfStats.messageTotalTime += messageTime;
+		if (messageTime > perfStats.messageMaxTime) perfStats.messageMaxTime = messageTime;
+		messageInProgress = false;
+		A6historyEntry entry;
+		if (messageLog && sentHistory.last(entry)) {
+			messageLog->append(getEpoch(), A6_LOG_SENT, entry.number, entry.message, entry.length);
+		}
+	}
+	setIdle();												// Message has fully be sent
+}
+
+/*!
+
+	\brief	Sends an SMS chunk to modem
+
+	This routine pushes an SMS chunk to modem.
+		Alphabet (and national language tables) are determined for this chunk only.
+
+	\param[in]	number: phone number to send message to
+	\param[in]	text: message to send
+	\param[in]	msgId: SMS message identifier (should be incremented for each multi-part message, zero if not multi-part message)
+	\param[in]	msgCount: total number of SMS chunks (zero if not multi-part message)
+	\param[in]	msgIndex: index of this message chunk (zero if not multi-part message)
+	\return	none
+
+*/
+void FF_A6lib::sendOneSmsChunk(const char* number, const char* text, const unsigned short msgId, const unsigned char msgCount, const unsigned char msgIndex) {
+	if (traceFlag) enterRoutine(__func__);
+	if (!destinationAllowed(number) || !setDestination(number)) return;
+	uint16_t utf8Length = strlen(text);
+	if (FF_A6text::gsm7ChooseTables(text, utf8Length, concatUdhLen(), smsLockingShift, smsSingleShift)) {
+		smsDcs = A6_DCS_GSM7;
+	} else {
+		smsDcs = A6_DCS_UCS2;
+	}
+	sendTextChunk(number, text, 0, utf8Length, msgId, msgCount, msgIndex);
+}
+
+/*!
+
+	\brief	[Private] Sends a text SMS chunk to modem
+
+	This routine converts part of an UTF-8 message into GSM-7 septets (with current national language tables)
+		or UTF-16 (including surrogate pairs), depending on current alphabet, and pushes it to modem
+
+	\param[in]	number: phone number to send message to
+	\param[in]	text: UTF-8 message containing chunk
+	\param[in]	startPos: chunk start position in text (bytes)
+	\param[in]	endPos: chunk end position in text (bytes, excluded)
+	\param[in]	msgId: SMS message identifier (zero if not multi-part message)
+	\param[in]	msgCount: total number of SMS chunks (zero if not multi-part message)
+	\param[in]	msgIndex: index of this message chunk (zero if not multi-part message)
+	\return	none
+
+*/
+void FF_A6lib::sendTextChunk(const char* number, const char* text, const uint16_t startPos, const uint16_t endPos, const unsigned short msgId, const unsigned char msgCount, const unsigned char msgIndex) {
+	if (traceFlag) enterRoutine(__func__);
+	uint8_t udh[12];
+	uint8_t udhLen = 0;
+	uint8_t userData[(A6_PDU_MAX_UD * 8) / 7];
+	uint16_t userDataLen;
+	if (msgCount) {											// Add concatenation header to multi-part messages
+		udhLen = FF_A6pdu::buildConcatUdh(udh, msgId, msgCount, msgIndex, concatReference16);
+	}
+	if (smsDcs == A6_DCS_GSM7) {
+		udhLen += FF_A6pdu::buildShiftUdh(udh + udhLen, smsLockingShift, smsSingleShift);
+		userDataLen = FF_A6text::gsm7Encode(text, startPos, endPos, userData, FF_A6pdu::udCapacity(A6_DCS_GSM7, udhLen), smsLockingShift, smsSingleShift);
+	} else {
+		userDataLen = FF_A6text::utf16Encode(text, startPos, endPos, userData, FF_A6pdu::udCapacity(A6_DCS_UCS2, udhLen) * 2);
+	}
+	int len = (userDataLen || startPos == endPos) ? a6Pdu.encodeSubmit(smsAddress, smsDcs, udh, udhLen, userData, userDataLen) : A6_PDU_TOO_LONG;
+	if (len < 0)  {
+			// -3 A6_PDU_TOO_LONG
+			// -5 A6_PDU_ADDRESS_FORMAT
+		trace_error_P("Encode error %d sending SMS to %s >%.*s<", len, number, endPos - startPos, text + startPos);
+		return;
+	}
+
+	if (debugFlag) trace_debug_P("Sending SMS to %s >%.*s<", number, endPos - startPos, text + startPos);
+	sendPdu(len, a6Pdu.getPdu());
+}
+
+/*!
+
+	\brief	[Private] Sends an encoded PDU to modem
+
+	This routine issues AT+CMGS, PDU being sent when modem prompt is received
+
+	\param[in]	len: TPDU length (octets, excluding SMSC field)
+	\param[in]	pdu: hex encoded PDU
+	\return	none
+
+*/
+void FF_A6lib::sendPdu(const int len, const char* pdu) {
+	if (traceFlag) enterRoutine(__func__);
+	char tempBuffer[50];
+	smsPduText = pdu;
+	chunkStartTime = millis();
+	if (gsmIdle != A6_SEND) {								// First chunk of message
+		messageInProgress = true;
+		messageStartTime = chunkStartTime;
+	}
+	gsmIdle = A6_SEND;
+	smsSentCount++;
+	snprintf_P(tempBuffer, sizeof(tempBuffer),PSTR("AT+CMGS=%d"), len);
+	sendCommand(tempBuffer, &FF_A6lib::sendSMStext, ">");
+}
+
+/*!
+
+	\brief	Register a SMS received callback routine
+
+	This routine register a callback routine to call when a SMS message is received
+
+	Callback routine will be called with 4 parameters:
+		(int) index: not used yet
+		(char*) number: phone number of SMS sender
+		(char*) date: date of received SMS (as delivered by the network)
+		(char*) message: received message in UTF-8 encoding
+
+	\param[in]	routine to call when a SMS is received
+	\return	none
+
+*/
+void FF_A6lib::registerSmsCb(void (*readSmsCallback)(int __index, const char* __number, const char* __date, const char* __message)) {
+	if (traceFlag) enterRoutine(__func__);
+	readSmsCb = readSmsCallback;
+}
+
+/*!
+
+	\brief	Register a SMS received callback routine, giving times as epoch
+
+	Callback routine will be called with 5 parameters:
+		(int) index: not used yet
+		(char*) number: phone number of SMS sender
+		(uint32_t) sentTime: time message reached service center (local time, 0 if unknown)
+		(uint32_t) receivedTime: time message reached gateway (local time, see getEpoch)
+		(char*) message: received message in UTF-8 encoding
+
+	It may be used in addition to registerSmsCb.
+
+	\param[in]	routine to call when a SMS is received
+	\return	none
+
+*/
+void FF_A6lib::registerTimedSmsCb(void (*readTimedSmsCallback)(int __index, const char* __number, const uint32_t __sentTime, const uint32_t __receivedTime, const char* __message)) {
+	if (traceFlag) enterRoutine(__func__);
+	readTimedSmsCb = readTimedSmsCallback;
+}
+
+/*!
+
+	\brief	Register a binary (8 bits) SMS received callback routine
+
+	This routine register a callback routine to call when a 8 bits SMS is received (multi-part ones being reassembled first)
+
+	Callback routine will be called with 6 parameters:
+		(int) index: not used yet
+		(char*) number: phone number of SMS sender
+		(char*) date: date of received SMS (as delivered by the network)
+		(uint8_t*) data: received data
+		(uint16_t) length: received data length
+		(uint16_t) port: destination application port (zero if none)
+
+	\param[in]	routine to call when a binary SMS is received
+	\return	none
+
+*/
+void FF_A6lib::registerBinaryCb(void (*readBinaryCallback)(int __index, const char* __number, const char* __date, const uint8_t* __data, const uint16_t __length, const uint16_t __port)) {
+	if (traceFlag) enterRoutine(__func__);
+	readBinaryCb = readBinaryCallback;
+}
+
+/*!
+
+	\brief	Register an answer received callback routine
+
+	This routine register a callback routine to call when an answer is received from modem
+
+	Callback routine will be called with 1 parameter:
+		(char*) answer: received answer
+
+	\param[in]	routine to call when a SMS is received
+	\return	none
+
+*/
+void FF_A6lib::registerLineCb(void (*recvLineCallback)(const char* __answer)) {
+	if (traceFlag) enterRoutine(__func__);
+	recvLineCb = recvLineCallback;
+}
+
+/*!
+
+	\brief	Delete SMS from the storage area
+
+	This routine delete (some) SMS from storage using AT+CMGD command
+	\param[in]	index as used by AT+CMGD
+	\param[in]	flag as used by AT+CMGD
+	\return	none
+
+*/
+void FF_A6lib::deleteSMS(int index, int flag) {
+	if (traceFlag) enterRoutine(__func__);
+	char tempBuffer[50];
+
+	snprintf_P(tempBuffer, sizeof(tempBuffer), PSTR("AT+CMGD=%d,%d"), index, flag);
+	sendCommand(tempBuffer, &FF_A6lib::setIdle, DEFAULT_ANSWER, 20000);	// Wait up to 20 seconds for OK
+}
+
+/*!
+
+	\brief	Issue an AT command (to be used as debug as no command tracking is done)
+
+	This routine will send an out of band AT command to modem.
+
+	It could be used to debug/test modem.
+
+	Modem answer is ignored and discarded.
+
+	\param[in]	AT command to be send
+	\return	none
+
+*/
+void FF_A6lib::sendAT(const char *command) {
+	if (traceFlag) enterRoutine(__func__);
+	sendCommand(command);
+	inReceive = false;
+}
+
+/*!
+
+	\brief	Issue an EOF command (to be used as debug as no command tracking is done)
+
+	This routine will send an EOF command to modem.
+
+	It could be used to debug/test modem.
+
+	Modem answer is ignored and discarded.
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6lib::sendEOF(void) {
+	if (traceFlag) enterRoutine(__func__);
+	sendCommand(0x1a);
+	inReceive = false;
+}
+
+/*!
+
+	\brief	Check if modem shoudl be restarted
+
+	This routine check if modem restart has been asked by code.
+
+	\param	none
+	\return	true if modem should be restarted, false else
+
+*/
+bool FF_A6lib::needRestart(void){
+	if (traceFlag) enterRoutine(__func__);
+	return restartNeeded;
+}
+
+/*!
+
+	\brief	Set the restart flag
+
+	This routine sets the restart required flag to a given value
+
+	\param[in]	value to be set (true or false)
+	\return	none
+
+*/
+void FF_A6lib::setRestart(bool restartFlag){
+	if (traceFlag) enterRoutine(__func__);
+	restartNeeded = restartFlag;
+}
+
+/*!
+
+	\brief	Checks if modem is idle
+
+	This routine checks if modem is idle (not initializing, sending nor receiving)
+
+	\param	none
+	\return	true if modem is idle, false else
+
+*/
+bool FF_A6lib::isIdle(void){
+	if (traceFlag) enterRoutine(__func__);
+	return (gsmIdle == A6_IDLE);
+}
+
+/*!
+
+	\brief	Checks if modem is sending something
+
+	This routine checks if modem is sending something (either commands or messages)
+
+	\param	none
+	\return	true is modem is sending, false else
+
+*/
+bool FF_A6lib::isSending(void){
+	if (traceFlag) enterRoutine(__func__);
+	return (gsmIdle == A6_SEND);
+}
+
+/*!
+
+	\brief	Checks if modem is receiving
+
+	This routine checks if modem is receiving a SMS
+
+	\param	none
+	\return	true if a SMS is receiving, false else
+
+*/
+bool FF_A6lib::isReceiving(void){
+	if (traceFlag) enterRoutine(__func__);
+	return (gsmIdle == A6_RECV);
+}
+
+/*!
+
+	\brief	[Private] Modem initialization: open modem at a given speed
+
+	\param[in]	baudRate: speed (in bds) to use to open modem
+	\return	none
+
+*/
+void FF_A6lib::openModem(long baudRate) {
+	if (traceFlag) enterRoutine(__func__);
+		if (debugFlag) trace_debug_P("Opening modem at %d bds", baudRate);
+        #ifdef USE_SOFTSERIAL_FOR_A6LIB
+            // Open modem at given speed
+        a6Serial.begin(baudRate, SWSERIAL_8N1, modemTxPin, modemRxPin, false, MAX_SMS_NUMBER_LEN + 3);	// Connect to Serial Software
+            // Enable TX interruption for speeds up to 19200 bds
+            a6Serial.enableIntTx((baudRate <= 19200));
+        #else
+            a6Serial.begin(baudRate, SERIAL_8N1);
+            #ifndef USE_DIRECT_CONNECTIONS_FOR_A6LIB
+            a6Serial.setDebugOutput(false);
+                a6Serial.swap();
+            #endif
+        #endif
+        // Flush pending input chars
+        while (a6Serial.available()) {
+			a6Serial.read();
+        }
+}
+
+/*!
+
+	\brief	Return restart reason
+
+	\param	none
+	\return	restart reason
+
+*/
+int FF_A6lib::getRestartReason(void) {
+    return restartReason;
+}
+
+/*!
+
+	\brief	[Private] Modem initialization: reset modem to factory defaults
+
+	\param	none
+	\return	none
 
 */
 void FF_A6lib::setReset(void) {
@@ -752,45 +2589,97 @@ void FF_A6lib::waitUntilSmsReady(void) {
 
 /*!
 
-	\brief	[Private] Modem initialization: set caller id on
+	\brief	[Private] Modem initialization: set caller id on
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6lib::setCallerId(void) {
+	if (traceFlag) enterRoutine(__func__);
+    ignoreErrors = false;
+	// Set caller ID on
+	sendCommand("AT+CLIP=1", &FF_A6lib::setIndicOff);
+}
+
+/*!
+
+	\brief	[Private] Modem initialization: set modem indicators
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6lib::setIndicOff(void) {
+	if (traceFlag) enterRoutine(__func__);
+	// Turn SMS indicators on
+	sendCommand("AT+CNMI=0,2,0,1,1", &FF_A6lib::setHeaderDetails);
+}
+
+/*!
+
+	\brief	[Private] Modem initialization: show results details
 
 	\param	none
 	\return	none
 
 */
-void FF_A6lib::setCallerId(void) {
+void FF_A6lib::setHeaderDetails(void) {
 	if (traceFlag) enterRoutine(__func__);
-    ignoreErrors = false;
-	// Set caller ID on
-	sendCommand("AT+CLIP=1", &FF_A6lib::setIndicOff);
+	// Show result details
+	sendCommand("AT+CSDH=1", modemScaFlag ? &FF_A6lib::deleteReadSent : scaFs ? &FF_A6lib::readIccid : &FF_A6lib::getSca);
 }
 
 /*!
 
-	\brief	[Private] Modem initialization: set modem indicators
+	\brief	[Private] Modem initialization: ask modem for SIM card identifier
+
+	Not all modems support it, so errors are ignored (SCA is then asked to modem).
 
 	\param	none
 	\return	none
 
 */
-void FF_A6lib::setIndicOff(void) {
+void FF_A6lib::readIccid(void) {
 	if (traceFlag) enterRoutine(__func__);
-	// Turn SMS indicators on
-	sendCommand("AT+CNMI=0,2,0,1,1", &FF_A6lib::setHeaderDetails);
+	ignoreErrors = true;
+	sendCommand("AT+CCID", &FF_A6lib::gotIccid, CCID_INDICATOR);
 }
 
 /*!
 
-	\brief	[Private] Modem initialization: show results details
+	\brief	[Private] Modem initialization: use SCA saved for this SIM card, or ask modem for it
 
 	\param	none
 	\return	none
 
 */
-void FF_A6lib::setHeaderDetails(void) {
+void FF_A6lib::gotIccid(void) {
 	if (traceFlag) enterRoutine(__func__);
-	// Show result details
-	sendCommand("AT+CSDH=1", &FF_A6lib::getSca);
+	ignoreErrors = false;
+	gsmStatus = A6_OK;
+	memset(iccid, 0, sizeof(iccid));
+	char* ptrStart = strstr(lastAnswer, CCID_INDICATOR);
+	if (ptrStart) {
+		ptrStart += strlen(CCID_INDICATOR);
+		uint8_t len = 0;
+		for (; *ptrStart && len < sizeof(iccid) - 1; ptrStart++) {
+			if (isalnum(*ptrStart)) {						// Skip spaces and quotes
+				iccid[len++] = *ptrStart;
+			}
+		}
+	}
+	if (iccid[0] && loadSca()) {
+		if (debugFlag) trace_debug_P("Using saved SCA %s for SIM %s", currentSca, iccid);
+		a6Pdu.setScaNumber(currentSca);
+		scaCheckNeeded = true;								// Check it later, when modem is idle
+		resetLastAnswer();
+		deleteReadSent();
+		return;
+	}
+	if (!iccid[0]) trace_warn_P("Can't get SIM card identifier from >%s<", lastAnswer);
+	resetLastAnswer();
+	getSca();
 }
 
 /*!
@@ -817,37 +2706,54 @@ void FF_A6lib::getSca(void) {
 */
 void FF_A6lib::gotSca(void) {
 	if (traceFlag) enterRoutine(__func__);
+	char scaNumber[MAX_SMS_NUMBER_LEN];
+	if (!parseSca(scaNumber)) {
+		restartReason = A6_BAD_ANSWER;
+		restartNeeded = true;
+		return;
+	}
+	if (debugFlag) trace_debug_P("setting SCA to %s", scaNumber);
+	a6Pdu.setScaNumber(scaNumber);
+	strncpy(currentSca, scaNumber, sizeof(currentSca));
+	if (iccid[0]) saveSca();
+	resetLastAnswer();
+	deleteReadSent();
+}
+
+/*!
+
+	\brief	[Private] Extract SCA number from modem answer
+
+	\param[out]	scaNumber: buffer to write SCA number into (MAX_SMS_NUMBER_LEN bytes)
+	\return	true if answer contains a valid SCA number, false else
+
+*/
+bool FF_A6lib::parseSca(char* scaNumber) {
 	// Extract SCA from message
 	char* ptrStart;
-	char scaNumber[MAX_SMS_NUMBER_LEN];
 
 	// Parse the response if it contains a valid CSCA_INDICATOR
 	ptrStart = strstr(lastAnswer, CSCA_INDICATOR);
 
 	if (ptrStart == NULL) {
 		trace_error_P("Can't find %s in %s",CSCA_INDICATOR, lastAnswer);
-		restartReason = A6_BAD_ANSWER;
-		restartNeeded = true;
-		return;
+		return false;
 	}
 	//	First token is +CSCA
 	char* token = strtok (ptrStart, "\"");
 	if (token == NULL) {
 		trace_error_P("Can't find first token in %s", lastAnswer);
-		restartReason = A6_BAD_ANSWER;
-		restartNeeded = true;
-		return;
+		return false;
 	}
 
 	// Second token is is SCA number
 	token = strtok (NULL, "\"");
 	if (token == NULL) {
 		trace_error_P("Can't find second token in %s", lastAnswer);
-		restartReason = A6_BAD_ANSWER;
-		restartNeeded = true;
-		return;
+		return false;
 	}
-	strncpy(scaNumber, token, sizeof(scaNumber));
+	strncpy(scaNumber, token, MAX_SMS_NUMBER_LEN);
+	scaNumber[MAX_SMS_NUMBER_LEN - 1] = 0;
 	// Check SCA number (first char can be "+", all other should be digit)
 	for (int i = 0; scaNumber[i]; i++) {
 		// Is char not a number?
@@ -855,16 +2761,121 @@ void FF_A6lib::gotSca(void) {
 			// First char could be '+'
 			if (scaNumber[0] != '+' || i != 0) {
 				trace_error_P("Bad SCA number %s at %d", scaNumber, i+1);
-				restartReason = A6_BAD_ANSWER;
-				restartNeeded = true;
-				return;
+				return false;
 			}
 		}
 	}
-	if (debugFlag) trace_debug_P("setting SCA to %s", scaNumber);
-	smsPdu.setSCAnumber(scaNumber);
-	resetLastAnswer();
-	deleteReadSent();
+	return true;
+}
+
+/*!
+
+	\brief	[Private] Ask modem for SCA number in background, to check the one loaded from store
+
+	Modem is marked busy during check. Errors are ignored, saved SCA being kept.
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6lib::checkSca(void) {
+	if (traceFlag) enterRoutine(__func__);
+	scaCheckNeeded = false;
+	gsmIdle = A6_CHECK;
+	sendCommand("AT+CSCA?", &FF_A6lib::gotCheckedSca, CSCA_INDICATOR, 10000);
+	backgroundCheck = true;
+}
+
+/*!
+
+	\brief	[Private] Update SCA number if modem gives another one than the one loaded from store
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6lib::gotCheckedSca(void) {
+	if (traceFlag) enterRoutine(__func__);
+	gsmStatus = A6_OK;
+	char scaNumber[MAX_SMS_NUMBER_LEN];
+	if (parseSca(scaNumber)) {
+		if (strcmp(scaNumber, currentSca)) {
+			trace_info_P("SCA changed from %s to %s", currentSca, scaNumber);
+			a6Pdu.setScaNumber(scaNumber);
+			strncpy(currentSca, scaNumber, sizeof(currentSca));
+			saveSca();
+		}
+	} else {
+		trace_warn_P("Keeping saved SCA %s", currentSca);
+	}
+	setIdle();
+}
+
+/*!
+
+	\brief	[Private] Load SCA number saved for current SIM card
+
+	\param	none
+	\return	true if SCA number has been found, false else
+
+*/
+bool FF_A6lib::loadSca(void) {
+	if (!scaFs || !scaFs->exists(scaFile)) {
+		return false;
+	}
+	File file = scaFs->open(scaFile, "r");
+	if (!file) {
+		return false;
+	}
+	A6scaEntry entry;
+	bool found = false;
+	while (!found && file.read((uint8_t*) &entry, sizeof(entry)) == sizeof(entry)) {
+		entry.iccid[sizeof(entry.iccid) - 1] = 0;
+		entry.sca[sizeof(entry.sca) - 1] = 0;
+		if (!strcmp(entry.iccid, iccid) && entry.sca[0]) {
+			strncpy(currentSca, entry.sca, sizeof(currentSca));
+			found = true;
+		}
+	}
+	file.close();
+	return found;
+}
+
+/*!
+
+	\brief	[Private] Save SCA number of current SIM card
+
+	Entry of current SIM card is written first, followed by other entries (oldest ones are dropped after A6_SCA_ENTRIES).
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6lib::saveSca(void) {
+	if (!scaFs) {
+		return;
+	}
+	A6scaEntry entries[A6_SCA_ENTRIES];
+	memset(entries, 0, sizeof(entries));
+	strncpy(entries[0].iccid, iccid, sizeof(entries[0].iccid));
+	strncpy(entries[0].sca, currentSca, sizeof(entries[0].sca) - 1);
+	uint8_t count = 1;
+	if (scaFs->exists(scaFile)) {							// Keep other SIM cards
+		File file = scaFs->open(scaFile, "r");
+		if (file) {
+			while (count < A6_SCA_ENTRIES && file.read((uint8_t*) &entries[count], sizeof(A6scaEntry)) == sizeof(A6scaEntry)) {
+				entries[count].iccid[sizeof(entries[count].iccid) - 1] = 0;
+				if (strcmp(entries[count].iccid, iccid)) count++;
+			}
+			file.close();
+		}
+	}
+	File file = scaFs->open(scaFile, "w");
+	if (!file || file.write((const uint8_t*) entries, count * sizeof(A6scaEntry)) != count * sizeof(A6scaEntry)) {
+		trace_error_P("Can't write %s", scaFile);
+	}
+	if (file) file.close();
+	if (debugFlag) trace_debug_P("Saved SCA %s for SIM %s", currentSca, iccid);
 }
 
 /*!
@@ -878,7 +2889,62 @@ void FF_A6lib::gotSca(void) {
 void FF_A6lib::deleteReadSent(void) {
 	if (traceFlag) enterRoutine(__func__);
 	// Delete read or sent SMS
-	sendCommand("AT+CMGD=1,4", &FF_A6lib::initComplete, DEFAULT_ANSWER, 10000);
+	sendCommand("AT+CMGD=1,4", modemClockFlag ? &FF_A6lib::enableNetworkTime : &FF_A6lib::initComplete, DEFAULT_ANSWER, 10000);
+}
+
+/*!
+
+	\brief	[Private] Modem initialization: ask modem to set its clock from network time
+
+	Not all modems support it, so errors are ignored.
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6lib::enableNetworkTime(void) {
+	if (traceFlag) enterRoutine(__func__);
+	ignoreErrors = true;
+	sendCommand("AT+CLTS=1", &FF_A6lib::readModemClock);
+}
+
+/*!
+
+	\brief	[Private] Modem initialization: read modem clock
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6lib::readModemClock(void) {
+	if (traceFlag) enterRoutine(__func__);
+	sendCommand("AT+CCLK?", &FF_A6lib::gotModemClock, CCLK_INDICATOR);
+}
+
+/*!
+
+	\brief	[Private] Modem initialization: set clock from modem answer
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6lib::gotModemClock(void) {
+	if (traceFlag) enterRoutine(__func__);
+	ignoreErrors = false;
+	gsmStatus = A6_OK;										// Modem clock is optional
+	uint32_t epoch;
+	int16_t modemTimeZone;
+	char* ptrStart = strstr(lastAnswer, CCLK_INDICATOR);
+	if (ptrStart && FF_A6clock::parseModemTime(ptrStart + strlen(CCLK_INDICATOR) + 1, epoch, modemTimeZone)) {
+		setTime(epoch);
+		timeZone = modemTimeZone;
+		if (debugFlag) trace_debug_P("Clock set from modem: %s", ptrStart);
+	} else {
+		trace_warn_P("Can't get modem clock from >%s<", lastAnswer);
+	}
+	resetLastAnswer();
+	initComplete();
 }
 
 /*!
@@ -896,7 +2962,18 @@ void FF_A6lib::initComplete(void) {
 		restartReason = gsmStatus;
 	} else {
 		setIdle();
-		trace_info_P("SMS gateway started, restart count = %d", restartCount);
+		perfStats.bootTime = millis() - beginTime;
+		if (recoveryMethod != A6_RECOVER_NONE) {			// End of recovery
+			unsigned long recoveryTime = millis() - recoveryStartTime;
+			A6recoveryStats& stats = recoveryStats[recoveryMethod];
+			stats.successCount++;
+			stats.totalTime += recoveryTime;
+			if (recoveryTime > stats.maxTime) stats.maxTime = recoveryTime;
+			trace_info_P("Modem recovered by method %d in %d ms", recoveryMethod, recoveryTime);
+			recoveryMethod = A6_RECOVER_NONE;
+			recoveryAttempts = 0;
+		}
+		trace_info_P("SMS gateway started in %d ms, restart count = %d", perfStats.bootTime, restartCount);
 		restartCount++;
 	}
 }
@@ -912,8 +2989,8 @@ void FF_A6lib::initComplete(void) {
 void FF_A6lib::sendSMStext(void) {
 	if (traceFlag) enterRoutine(__func__);
 
-	if (debugFlag) trace_debug_P("Message: %s", smsPdu.getSMS());
-	a6Serial.write(smsPdu.getSMS());
+	if (debugFlag) trace_debug_P("Message: %s", smsPduText);
+	a6Serial.write(smsPduText);
 	sendCommand(0x1a, &FF_A6lib::sendNextSmsChunk, "+CMGS:", 10000);
 }
 
@@ -952,7 +3029,7 @@ void FF_A6lib::waitSmsReady(unsigned long waitMs, void (FF_A6lib::*nextStep)(voi
 void FF_A6lib::sendCommand(const char *command, void (FF_A6lib::*nextStep)(void), const char *resp, unsigned long cdeTimeout) {
 	if (traceFlag) enterRoutine(__func__);
 	commandCount++;
-	gsmTimeout = cdeTimeout;
+	gsmTimeout = commandTimeout(command, cdeTimeout);
 	gsmStatus = A6_RUNNING;
 	nextStepCb = nextStep;
 	strncpy(expectedAnswer, resp, sizeof(expectedAnswer));
@@ -969,6 +3046,7 @@ void FF_A6lib::sendCommand(const char *command, void (FF_A6lib::*nextStep)(void)
 	inWait = false;
 	inWaitSmsReady = false;
 	nextLineIsSmsMessage = false;
+	backgroundCheck = false;
 }
 
 /*!
@@ -985,7 +3063,9 @@ void FF_A6lib::sendCommand(const char *command, void (FF_A6lib::*nextStep)(void)
 void FF_A6lib::sendCommand(const uint8_t command, void (FF_A6lib::*nextStep)(void), const char *resp, unsigned long cdeTimeout) {
 	if (traceFlag) enterRoutine(__func__);
 	commandCount++;
-	gsmTimeout = cdeTimeout;
+	char commandName[6];
+	snprintf_P(commandName, sizeof(commandName), PSTR("<%02X>"), command);
+	gsmTimeout = commandTimeout(commandName, cdeTimeout);
 	gsmStatus = A6_RUNNING;
 	nextStepCb = nextStep;
 	strncpy(expectedAnswer, resp, sizeof(expectedAnswer));
@@ -995,6 +3075,7 @@ void FF_A6lib::sendCommand(const uint8_t command, void (FF_A6lib::*nextStep)(voi
 	startTime = millis();
 	inReceive = true;
 	inWaitSmsReady = false;
+	backgroundCheck = false;
 }
 
 /*!
@@ -1009,6 +3090,8 @@ void FF_A6lib::setIdle(void) {
 	if (traceFlag) enterRoutine(__func__);
 	gsmIdle = A6_IDLE;
 	inReceive = false;
+	backgroundCheck = false;
+	heartbeatTime = millis();								// Restart heartbeat delay
 	resetLastAnswer();
 }
 
@@ -1062,22 +3145,249 @@ void FF_A6lib::readSmsHeader(const char* msg) {
 */
 void FF_A6lib::readSmsMessage(const char* msg) {
 	if (traceFlag) enterRoutine(__func__);
-	if (smsPdu.decodePDU(msg)) {
+	A6_HEAP_PROBE(A6_HEAP_READ_SMS);
+	A6deliver deliver;
+	bool decoded = FF_A6pdu::decodeDeliver(msg, deliver);
+	if (decoded && !senderAllowed(deliver.sender)) {		// Check sender before decoding message
+		deleteSMS(1,2);
+		return;
+	}
+	if (isDuplicate(decoded ? &deliver : NULL, msg)) {
+		deleteSMS(1,2);
+		return;
+	}
+	if (decoded && FF_A6pdu::dcsAlphabet(deliver.dcs) == A6_DCS_8BIT) {
+		readBinaryMessage(deliver);							// 8 bits messages are not handled by pdulib
+	} else if (smsPdu.decodePDU(msg)) {
 		if (smsPdu.getOverflow()) {
 			trace_warn_P("SMS decode overflow, partial message only", NULL);
 		}
-		lastReceivedNumber = String(smsPdu.getSender());
-		lastReceivedDate = String(smsPdu.getTimeStamp());
-		lastReceivedMessage = String(smsPdu.getText());
-		smsForwardedCount++;
-		if (debugFlag) trace_debug_P("Got SMS from %s, sent at %s, >%s<", lastReceivedNumber.c_str(), lastReceivedDate.c_str(), lastReceivedMessage.c_str());
-        if (readSmsCb) (*readSmsCb)(index, lastReceivedNumber.c_str(), lastReceivedDate.c_str(), lastReceivedMessage.c_str());
+		if (!decoded && !senderAllowed(smsPdu.getSender())) {
+			deleteSMS(1,2);
+			return;
+		}
+		notifySms(smsPdu.getSender(), smsPdu.getTimeStamp(), smsPdu.getText(), decoded ? deliver.timeStamp : NULL);
 	} else {
 		trace_error_P("SMS PDU decode failed", NULL);
 	}
 	deleteSMS(1,2);
 }
 
+/*!
+
+	\brief	[Private] Read a decoded binary (8 bits) SMS
+
+	Multi-part messages are reassembled before being given to callback.
+
+	\param[in]	deliver: decoded PDU
+	\return	none
+
+*/
+void FF_A6lib::readBinaryMessage(const A6deliver& deliver) {
+	if (traceFlag) enterRoutine(__func__);
+	char date[24];
+	char tempBuffer[30];
+	const uint8_t* data = deliver.userData;
+	uint16_t dataLen = deliver.userDataLen;
+	FF_A6pdu::formatTimeStamp(deliver.timeStamp, date, sizeof(date));
+	if (deliver.concatCount > 1) {							// Multi-part message
+		if (strcmp(deliver.sender, binaryRecvSender) || deliver.concatReference != binaryRecvReference || deliver.concatCount != binaryRecvCount) {
+			// New message, forget previous (incomplete) one
+			strncpy(binaryRecvSender, deliver.sender, sizeof(binaryRecvSender));
+			binaryRecvReference = deliver.concatReference;
+			binaryRecvCount = deliver.concatCount;
+			binaryRecvMask = 0;
+			binaryRecvLength = 0;
+		}
+		// All chunks have same header, so same capacity
+		uint16_t offset = (deliver.concatIndex - 1) * FF_A6pdu::udCapacity(A6_DCS_8BIT, deliver.udhLen);
+		if (!deliver.concatIndex || deliver.concatIndex > deliver.concatCount || deliver.concatCount > 32
+				|| offset + deliver.userDataLen > sizeof(binaryRecvBuffer)) {
+			trace_error_P("Can't reassemble part %d/%d of %d bytes from %s", deliver.concatIndex, deliver.concatCount, deliver.userDataLen, deliver.sender);
+			return;
+		}
+		memcpy(binaryRecvBuffer + offset, deliver.userData, deliver.userDataLen);
+		binaryRecvMask |= 1UL << (deliver.concatIndex - 1);
+		if (offset + deliver.userDataLen > binaryRecvLength) {
+			binaryRecvLength = offset + deliver.userDataLen;
+		}
+		if (debugFlag) trace_debug_P("Got part %d/%d of binary SMS from %s", deliver.concatIndex, deliver.concatCount, deliver.sender);
+		if (binaryRecvMask != (0xffffffffUL >> (32 - deliver.concatCount))) {
+			return;											// Wait for other parts
+		}
+		data = binaryRecvBuffer;
+		dataLen = binaryRecvLength;
+		binaryRecvCount = 0;
+	}
+	if (deliver.hasPorts && deliver.destinationPort == A6_COMPRESS_PORT) {
+		// Compressed text message, decompress it and give it to SMS callback
+		uint16_t textLen = FF_A6compress::decompress(data, dataLen, textBuffer, sizeof(textBuffer));
+		if (textLen) {
+			if (debugFlag) trace_debug_P("Decompressed %d bytes into %d", dataLen, textLen);
+			notifySms(deliver.sender, date, textBuffer, deliver.timeStamp);
+			return;
+		}
+		trace_error_P("Can't decompress %d bytes from %s", dataLen, deliver.sender);
+	}
+	snprintf_P(tempBuffer, sizeof(tempBuffer), PSTR("[%d bytes of data]"), dataLen);
+	uint32_t sentTime = recordDelay(deliver.timeStamp);
+	receivedHistory.add(sentTime ? sentTime : getEpoch(), deliver.sender, tempBuffer, strlen(tempBuffer));
+	if (messageLog) messageLog->append(getEpoch(), A6_LOG_RECEIVED, deliver.sender, tempBuffer, strlen(tempBuffer));
+	smsForwardedCount++;
+	if (debugFlag) trace_debug_P("Got %d bytes from %s, sent at %s, port %d", dataLen, deliver.sender, date, deliver.destinationPort);
+	if (readBinaryCb) (*readBinaryCb)(index, deliver.sender, date, data, dataLen, deliver.destinationPort);
+}
+
+/*!
+
+	\brief	[Private] Check if a received message has already been received recently
+
+	Messages are identified by a hash of sender, service center time stamp and user data, kept in a small ring of recent messages.
+
+	\param[in]	deliver: decoded PDU (NULL if PDU can't be decoded)
+	\param[in]	pdu: received PDU (used when it can't be decoded)
+	\return	true if message has already been received during dedup window
+
+*/
+bool FF_A6lib::isDuplicate(const A6deliver* deliver, const char* pdu) {
+	if (!dedupWindow) {
+		return false;
+	}
+	uint32_t hash;
+	if (deliver) {
+		hash = fnvHash(deliver->sender, strlen(deliver->sender));
+		hash = fnvHash(deliver->timeStamp, sizeof(deliver->timeStamp), hash);
+		hash = fnvHash(&deliver->udhLen, 1, hash);
+		hash = fnvHash(&deliver->concatIndex, 1, hash);
+		hash = fnvHash(deliver->userData, deliver->userDataLen, hash);
+	} else {
+		hash = fnvHash(pdu, strlen(pdu));
+	}
+	unsigned long now = millis();
+	for (uint8_t i = 0; i < A6_DEDUP_SIZE; i++) {
+		if (dedupCache[i].hash == hash && dedupCache[i].time && now - dedupCache[i].time < dedupWindow * 1000UL) {
+			duplicateCount++;
+			trace_warn_P("Dropping duplicate SMS received %d s ago", (now - dedupCache[i].time) / 1000);
+			return true;
+		}
+	}
+	dedupCache[dedupNext].hash = hash;
+	dedupCache[dedupNext].time = now | 1;					// Never 0, as 0 means unused
+	dedupNext = (dedupNext + 1) % A6_DEDUP_SIZE;
+	return false;
+}
+
+/*!
+
+	\brief	[Private] Check if a message from a sender should be given to callbacks
+
+	\param[in]	sender: sender phone number
+	\return	true if there's no allow list, or if sender is in it
+
+*/
+bool FF_A6lib::senderAllowed(const char* sender) {
+	if (!allowList || allowList->contains(sender)) {
+		return true;
+	}
+	droppedInboundCount++;
+	if (debugFlag) trace_info_P("Dropping SMS from %s, not in allow list", sender);
+	return false;
+}
+
+/*!
+
+	\brief	[Private] Check if a message may be sent to a destination
+
+	\param[in]	number: destination phone number
+	\return	true if there's no block list, or if destination is not in it
+
+*/
+bool FF_A6lib::destinationAllowed(const char* number) {
+	if (!blockList || !blockList->contains(number)) {
+		return true;
+	}
+	suppressedOutboundCount++;
+	if (debugFlag) trace_info_P("Not sending to %s, in block list", number);
+	return false;
+}
+
+/*!
+
+	\brief	[Private] Encode destination of message being sent
+
+	Address is encoded once, and reused by all chunks of multi-part messages.
+
+	\param[in]	number: destination phone number
+	\return	true if number is valid, false else
+
+*/
+bool FF_A6lib::setDestination(const char* number) {
+	if (!FF_A6pdu::encodeNumber(number, smsAddress)) {
+		trace_error_P("Bad number: %s", number);
+		return false;
+	}
+	return true;
+}
+
+/*!
+
+	\brief	[Private] Give a received text message to callbacks
+
+	\param[in]	sender: sender phone number
+	\param[in]	date: service center date, as delivered by the network
+	\param[in]	message: received message (UTF-8)
+	\param[in]	timeStamp: raw service center time stamp (NULL if not decoded)
+	\return	none
+
+*/
+void FF_A6lib::notifySms(const char* sender, const char* date, const char* message, const uint8_t* timeStamp) {
+	if (traceFlag) enterRoutine(__func__);
+	uint32_t sentTime = recordDelay(timeStamp);
+	if (!receivedHistory.add(sentTime ? sentTime : getEpoch(), sender, message, strlen(message))) {
+		trace_warn_P("Message from %s too long to be kept in history", sender);
+	}
+	if (messageLog) messageLog->append(getEpoch(), A6_LOG_RECEIVED, sender, message, strlen(message));
+	smsForwardedCount++;
+	if (debugFlag) trace_debug_P("Got SMS from %s, sent at %s, >%s<", sender, date, message);
+	if (router && router->dispatch(sender, message)) {
+		routedCount++;
+		return;												// Command has been handled
+	}
+	if (readSmsCb) (*readSmsCb)(index, sender, date, message);
+	if (readTimedSmsCb) (*readTimedSmsCb)(index, sender, sentTime, getEpoch(), message);
+}
+
+/*!
+
+	\brief	[Private] Account delay between service center and gateway for a received message
+
+	\param[in]	timeStamp: raw service center time stamp (NULL if not decoded)
+	\return	Service center time, in local time of gateway (0 if unknown)
+
+*/
+uint32_t FF_A6lib::recordDelay(const uint8_t* timeStamp) {
+	static const uint16_t bucketLimits[A6_DELAY_BUCKETS - 1] = {10, 30, 60, 120, 300, 900, 3600};	// Upper limits of buckets (s)
+	uint32_t utcTime = timeStamp ? FF_A6pdu::timeStampToEpoch(timeStamp) : 0;
+	if (!utcTime) {
+		delayUnknownCount++;
+		return 0;
+	}
+	uint32_t sentTime = utcTime + timeZone * 60L;			// Same time zone as gateway clock
+	if (!timeSourceCb && !clockBase) {						// Gateway time is not known
+		delayUnknownCount++;
+		return sentTime;
+	}
+	uint32_t now = getEpoch();
+	uint32_t delay = (now > sentTime) ? now - sentTime : 0;	// Clocks may be slightly different
+	uint8_t bucket = 0;
+	while (bucket < A6_DELAY_BUCKETS - 1 && delay >= bucketLimits[bucket]) {
+		bucket++;
+	}
+	delayHistogram[bucket]++;
+	if (debugFlag) trace_debug_P("Delivered after %d s", delay);
+	return sentTime;
+}
+
 /*!
 
 	\brief	[Private] Clean ast answer
@@ -1095,7 +3405,7 @@ void FF_A6lib::resetLastAnswer(void) {
 
 	\brief	Return GSM7 equivalent length of one UTF-8 character
 
-	This routine takes one UTF-8 character coded on up-to 3 bytes to return it's length when coded in GSM7
+	This routine takes one UTF-8 character coded on up-to 3 bytes to return it's length when coded in GSM7 (default alphabet and extension table)
 
 	\param[in]	c1: first byte of UTF-8 character to analyze
 	\param[in]	c2: second byte of UTF-8 character to analyze (or zero if end of message)
@@ -1105,90 +3415,35 @@ void FF_A6lib::resetLastAnswer(void) {
 */
 
 uint8_t FF_A6lib::getGsm7EquivalentLen(const uint8_t c1, const uint8_t c2, const uint8_t c3) {
-	if (
-			// These are one byte UTF8 char coded on one byte GSM7 char
-			(c1 == 0x0a)	/* Linefeed */ 																						||
-			(c1 == 0x0d)	/* Carriage return */ 																				||
-			(c1 >= 0x20		/* Space */ 								&& c1 <= 0x5a) /* Capital letter Z */					|| 
-			(c1 == 0x5f)	/* Underscore */ 																					||
-			(c1 >= 0x61		/* Small letter a */ 						&& c1 <= 0x7a) /* Small letter z */ 
-		) {
-			return 1;
-	}
-	if ((c1 == 0xc2) && (
-			// These are two bytes UTF8 char coded on one byte GSM7 char
-			(c2 == 0xa1)	/* Inverted exclamation mark */																		||
-			(c2 >= 0xa3		/* Pound sign */							&& c2 <= 0xa5) /* Yuan/Yen sign */						|| 
-			(c2 == 0xa7)	/* Section sign */ 																					||
-			(c2 == 0xbf)	/* Inverted question mark */
-		)) {
-			return 1;
-	}
-	if ((c1 == 0xc3) && (
-			// These are two bytes UTF8 char coded on one byte GSM7 char
-			(c2 >= 0x84		/* Capital letter A with diaeresis */		&& c2 <= 0x87) /* Capital letter C with cedilla */		|| 
-			(c2 == 0x89)	/* Capital letter E with acute accent */															|| 
-			(c2 == 0x91)	/* Capital letter N with tilde */																	||
-			(c2 == 0x96)	/* Capital letter O with diaeresis */																||
-			(c2 == 0x98)	/* Capital letter O with stroke */																	||
-			(c2 == 0x9c)	/* Capital letter U with diaeresis */																||
-			(c2 >= 0x9f		/* Small letter German Eszett */			&& c2 <= 0xa0) /* Small letter a with grave accent */	|| 
-			(c2 >= 0xa4		/* Small letter a with diaeresis */			&& c2 <= 0xa6) /* Small letter ae */					|| 
-			(c2 >= 0xa8		/* Small letter e with grave accent */		&& c2 <= 0xa9) /* Small letter e with acute accent */	|| 
-			(c2 == 0xac)	/* Small letter i with grave accent */																||
-			(c2 >= 0xb1		/* Small letter n with tilde */				&& c2 <= 0xb2) /* Small letter o with grave accent */	|| 
-			(c2 == 0xb6)	/* Small letter o with diaeresis */																	||
-			(c2 >= 0xb8		/* Small letter o with stroke */			&& c2 <= 0xb9) /* Small letter u with grave accent */	|| 
-			(c2 == 0xbc)	/* Small letter u with diaeresis */ 
-		)) {
-			return 1;
-	}
-	if (
-			// These are one byte UTF8 char coded on two bytes GSM7 char
-			(c1 == 0x0c)	/* Form feed */ ||
-			(c1 >= 0x5b		/* Left square bracket */					&& c1 <= 0x5e) /* Caret / Circumflex */					|| 
-			(c1 >= 0x7b		/* Left curly bracket */					&& c1 <= 0x7e) /* Tilde */
-		) {
-			return 2;
-	}
-	if (c1 == 0xe2 && 
-			// This is three bytes UTF8 char coded on two bytes GSM7 char
-			c2 == 0x82 &&
-			c3 == 0xac 		/* Euro sign */
-		) {
-		return 2;
-	}
-	return 0;
-}
-
-/*!
-
-	\brief	Return UCS-2 equivalent length of one UTF-8 character
-
-	This routine takes one UTF-8 message to return it's length when coded in UCS-2
+	const char utf8Char[3] = {(char) c1, (char) c2, (char) c3};
+	uint16_t pos = 0;
+	// Decode UTF-8 character, then look for it in default alphabet and extension table
+	return FF_A6text::gsm7Septets(FF_A6text::utf8Next(utf8Char, c2 ? (c3 ? 3 : 2) : 1, pos), A6_LANG_DEFAULT, A6_LANG_DEFAULT);
+}
+
+/*!
+
+	\brief	Return UCS-2 equivalent length of an UTF-8 message
+
+	This routine takes one UTF-8 message to return it's length when coded in UCS-2 (UTF-16).
+		Characters outside Basic Multilingual Plane (like emoji) need a surrogate pair, and count for 4 bytes.
 
 	\param[in]	text: message to be scanned
-	\return	Length of character when coded in UCS-2
+	\return	Length of message when coded in UCS-2 (bytes)
 
 */
 
 uint16_t FF_A6lib::ucs2MessageLength(const char* text) {
-	uint16_t utf8CharCount = 0;
-
-	// Get UTF-8 message length
-	while (*text) {
-		// Cout only first byte of each UTF-8 sequence
-		utf8CharCount += (*text++ & 0xc0) != 0x80;
-	}
-	// UCS-2 if 2 chars for each UTF-8 character
-	return utf8CharCount * 2;
+	// UCS-2 is 2 bytes for each UTF-16 unit
+	return FF_A6text::utf16Length(text, strlen(text)) * 2;
 }
 
 /*!
 
 	\brief	Return phone number of last received SMS
 
-	This routine returns the phone number of last received SMS
+	This routine returns the phone number of last received SMS, pointing into received messages history.
+		Pointer is valid until next SMS is received, copy number if it should be kept longer.
 
 	\param	None
 	\return	Phone number of last received SMS
@@ -1196,75 +3451,116 @@ uint16_t FF_A6lib::ucs2MessageLength(const char* text) {
 */
 
 const char* FF_A6lib::getLastReceivedNumber(void) {
-	return lastReceivedNumber.c_str();
+	A6historyEntry entry;
+	return receivedHistory.last(entry) ? entry.number : "[none]";
 }
 
 /*!
 
 	\brief	Return date of last received SMS
 
-	This routine returns the phone number of last received SMS
+	This routine returns the date of last received SMS (given by service center), as "dd/mm/yyyy hh:mm:ss"
 
 	\param	None
 	\return	Date of last received SMS
 
 */
 const char* FF_A6lib::getLastReceivedDate(void) {
-	return lastReceivedDate.c_str();
+	A6historyEntry entry;
+	if (!receivedHistory.last(entry)) {
+		return "[never]";
+	}
+	FF_A6clock::format(entry.time, lastReceivedDate, sizeof(lastReceivedDate));	// Format only when asked for
+	return lastReceivedDate;
 }
 
 /*!
 
 	\brief	Return message of last received SMS
 
-	This routine returns the message of last received SMS
+	This routine returns the message of last received SMS, pointing into received messages history.
+		Pointer is valid until next SMS is received, copy message if it should be kept longer.
 
 	\param	None
 	\return	Message of last received SMS
 
 */
 const char* FF_A6lib::getLastReceivedMessage(void) {
-	return lastReceivedMessage.c_str();
+	A6historyEntry entry;
+	return receivedHistory.last(entry) ? entry.message : "[no message]";
 }
 
 /*!
 
 	\brief	Return phone number of last sent SMS
 
-	This routine returns the phone number of last sent SMS
+	This routine returns the phone number of last sent SMS, pointing into sent messages history.
+		Pointer is valid until next SMS is sent, copy number if it should be kept longer.
 
 	\param	None
 	\return	Phone number of last sent SMS
 
 */
 const char* FF_A6lib::getLastSentNumber(void) {
-	return lastSentNumber.c_str();
+	A6historyEntry entry;
+	return sentHistory.last(entry) ? entry.number : "[none]";
 }
 
 /*!
 
 	\brief	Return date of last sent SMS
 
-	This routine returns the date of last sent SMS
+	This routine returns the date of last sent SMS, as "dd/mm/yyyy hh:mm:ss"
 
 	\param	None
 	\return	Date of last sent SMS
 
 */
 const char* FF_A6lib::getLastSentDate(void) {
-	return lastSentDate.c_str();
+	A6historyEntry entry;
+	if (!sentHistory.last(entry)) {
+		return "[never]";
+	}
+	FF_A6clock::format(entry.time, lastSentDate, sizeof(lastSentDate));	// Format only when asked for
+	return lastSentDate;
 }
 
 /*!
 
 	\brief	Return message of last sent SMS
 
-	This routine returns the message of last sent SMS
+	This routine returns the message of last sent SMS, pointing into sent messages history.
+		Pointer is valid until next SMS is sent, copy message if it should be kept longer.
 
 	\param	None
 	\return	Message of last sent SMS
 
 */
 const char* FF_A6lib::getLastSentMessage(void) {
-	return lastSentMessage.c_str();
+	A6historyEntry entry;
+	return sentHistory.last(entry) ? entry.message : "[no message]";
+}
+
+/*!
+
+	\brief	Return history of sent messages
+
+	\param	None
+	\return	History of last sent messages (see FF_A6history)
+
+*/
+FF_A6history& FF_A6lib::getSentHistory(void) {
+	return sentHistory;
+}
+
+/*!
+
+	\brief	Return history of received messages
+
+	\param	None
+	\return	History of last received messages (see FF_A6history)
+
+*/
+FF_A6history& FF_A6lib::getReceivedHistory(void) {
+	return receivedHistory;
 }
@@ -12,6 +12,18 @@
 #define FF_A6lib_h
 
 #include <Arduino.h>
+#include <FS.h>
+#include <FF_A6pdu.h>
+#include <FF_A6text.h>
+#include <FF_A6clock.h>
+#include <FF_A6numberSet.h>
+#include <FF_A6router.h>
+#include <FF_A6history.h>
+#include <FF_A6log.h>
+#include <FF_A6json.h>
+#include <FF_A6power.h>
+#include <FF_A6template.h>
+#include <FF_A6compress.h>
 
 // Constants
 #define A6_CMD_TIMEOUT 4000									//!< Standard AT command timeout (ms)
@@ -21,6 +33,36 @@
 #define SMS_READY_MSG "SMS Ready"							//!< SMS ready signal
 #define SMS_INDICATOR "+CMT: "								//!< SMS received indicator
 #define CSCA_INDICATOR "+CSCA:"								//!< SCA value indicator
+#define CCLK_INDICATOR "+CCLK:"								//!< Modem clock value indicator
+#define CCID_INDICATOR "+CCID:"								//!< SIM card identifier value indicator
+#ifndef A6_MAX_BINARY_LEN
+	#define A6_MAX_BINARY_LEN 384							//!< Max length of binary data sent or received (bytes)
+#endif
+#ifndef A6_MAX_TEXT_LEN
+	#define A6_MAX_TEXT_LEN 640								//!< Max length of decompressed received text, or of message resent from history (bytes)
+#endif
+#ifndef A6_QUEUE_SIZE
+	#define A6_QUEUE_SIZE 1024								//!< Size of outbound queue arena (bytes)
+#endif
+#define A6_QUEUE_HEADER_LEN 8								//!< Length of outbound queue record header
+#define A6_DEDUP_SIZE 16										//!< Count of recent received messages remembered to drop duplicates
+#define A6_DEDUP_WINDOW 600									//!< Default duplicate received messages window (s)
+#define A6_DELAY_BUCKETS 8									//!< Count of buckets in delivery delay histogram
+#define A6_REFERENCE_BLOCK 16								//!< Count of concatenated message references reserved at once
+#define A6_REFERENCE_DESTINATIONS 4							//!< Count of destinations with their own block of references
+#define A6_REFERENCE_PATH_LEN 32							//!< Max length of reference counter file name (including final zero)
+#define A6_ICCID_LEN 21										//!< Max length of SIM card identifier (including final zero)
+#define A6_SCA_ENTRIES 4									//!< Count of SIM cards whose SCA is kept in SCA store
+#define A6_SCA_PATH_LEN 32									//!< Max length of SCA store file name (including final zero)
+#define A6_HEARTBEAT_MIN_INTERVAL 15						//!< Shortest interval between idle heartbeats (s)
+#define A6_HEARTBEAT_TIMEOUT 2000							//!< Heartbeat answer timeout (ms)
+#define A6_HEARTBEAT_MAX_MISSES 2							//!< Count of consecutive missed heartbeats asking for a restart
+#define A6_LATENCY_SLOTS 20									//!< Count of commands whose latency is tracked
+#define A6_LATENCY_COMMAND_LEN 10							//!< Max length of tracked command name (including final zero)
+#define A6_LATENCY_MIN_SAMPLES 4							//!< Count of answers needed before adapting command timeout
+#define A6_LATENCY_MARGIN 250								//!< Margin added to adaptive timeouts (ms)
+#define A6_LATENCY_NONE 0xff								//!< No tracked command
+//#define FF_A6LIB_HEAP_STATS								//!< Account heap usage of main operations (see getHeapStats)
 //#define A6LIB_KEEP_CR_LF									//!< Keep CR & LF in displayed messages (by default, thry're replaced by ".")
 
 // Enums
@@ -32,10 +74,123 @@
 #define A6_CM_ERROR 4
 #define A6_NEED_INIT 5
 
+#define A6_QUEUE_TEXT 1
+#define A6_QUEUE_BINARY 2
+#define A6_QUEUE_COMPRESSED 3
+
+#define A6_JSON_STATUS 1									//!< writeJson section: modem status
+#define A6_JSON_COUNTERS 2									//!< writeJson section: counters and statistics
+#define A6_JSON_QUEUE 4										//!< writeJson section: queued messages
+#define A6_JSON_HISTORY 8									//!< writeJson section: sent and received messages history
+#define A6_JSON_ALL 0x0f									//!< writeJson section: all of them
+#define A6_QUEUE_WRAP 0xff
+#define A6_QUEUE_FULL 0xffff
+
+#define A6_HEAP_SEND_SMS 0
+#define A6_HEAP_SEND_TEMPLATE 1
+#define A6_HEAP_SEND_BINARY 2
+#define A6_HEAP_SEND_COMPRESSED 3
+#define A6_HEAP_READ_SMS 4
+#define A6_HEAP_DO_LOOP 5
+#define A6_HEAP_OPERATIONS 6
+
 #define A6_IDLE 0
 #define A6_SEND 1
 #define A6_RECV 2
 #define A6_STARTING 3
+#define A6_CHECK 4
+
+#define A6_RECOVER_SOFT 0									//!< Recovery method: initialize modem again
+#define A6_RECOVER_RESET 1									//!< Recovery method: pulse reset line, then initialize modem
+#define A6_RECOVER_POWER 2									//!< Recovery method: switch modem off and on with power key, then initialize it
+#define A6_RECOVER_METHODS 3								//!< Count of recovery methods
+#define A6_RECOVER_NONE 0xff								//!< No recovery running
+
+#define A6_POWER_IDLE 0
+#define A6_POWER_RESETTING 1
+#define A6_POWER_OFF 2
+#define A6_POWER_OFF_WAITING 3
+#define A6_POWER_ON 4
+#define A6_POWER_BOOTING 5
+#define A6_POWER_PROBING 6
+
+/*!
+	\struct A6referenceEntry
+	\brief	Block of concatenated message references reserved for a destination
+*/
+struct A6referenceEntry {
+	uint32_t numberHash;									//!< Hash of destination number
+	uint32_t lastUse;										//!< Time of last use (ms, 0 if unused)
+	uint16_t next;											//!< Next reference to use
+	uint8_t left;											//!< Count of references left in block
+};
+
+/*!
+	\struct A6scaEntry
+	\brief	SCA (service center) number of a SIM card, as saved in SCA store
+*/
+struct A6scaEntry {
+	char iccid[A6_ICCID_LEN];								//!< SIM card identifier
+	char sca[MAX_SMS_NUMBER_LEN];							//!< SCA number
+};
+
+/*!
+	\struct A6perfStats
+	\brief	Performance counters
+*/
+struct A6perfStats {
+	unsigned long bootTime;									//!< Time from begin to modem ready (ms)
+	unsigned long messageCount;								//!< Count of fully sent messages
+	unsigned long messageTotalTime;							//!< Total time spent sending messages (ms)
+	unsigned long messageMaxTime;							//!< Longest time spent sending a message (ms)
+	unsigned long chunkCount;								//!< Count of acknowledged chunks
+	unsigned long chunkTotalTime;							//!< Total time spent sending chunks (ms)
+	unsigned long chunkMaxTime;								//!< Longest time spent sending a chunk (ms)
+};
+
+/*!
+	\struct A6recoveryStats
+	\brief	Counters of a recovery method
+*/
+struct A6recoveryStats {
+	unsigned long count;									//!< Count of recoveries started with this method
+	unsigned long successCount;								//!< Count of recoveries ending with modem ready
+	unsigned long totalTime;								//!< Total time of successful recoveries (ms)
+	unsigned long maxTime;									//!< Longest successful recovery (ms)
+};
+
+/*!
+	\struct A6latency
+	\brief	Observed answer latency of a command (average and mean deviation, as TCP round trip time estimator)
+*/
+struct A6latency {
+	char command[A6_LATENCY_COMMAND_LEN];					//!< Command name (up to "=" or "?")
+	uint16_t average;										//!< Smoothed latency (ms)
+	uint16_t deviation;										//!< Smoothed mean deviation (ms)
+	uint16_t count;											//!< Count of samples
+};
+
+/*!
+	\struct A6heapStats
+	\brief	Heap accounting of an operation (when FF_A6LIB_HEAP_STATS is defined)
+*/
+struct A6heapStats {
+	unsigned long calls;									//!< Count of calls
+	unsigned long growingCalls;								//!< Count of calls leaving less free heap than at entry
+	long totalDelta;										//!< Total heap retained by calls (bytes, negative if freed)
+	unsigned long allocations;								//!< Count of allocations during calls (only with UMM_STATS_FULL, else 0)
+	uint32_t peakUsage;										//!< Largest heap used during a call (bytes, at exit only without UMM_STATS_FULL)
+	uint32_t minFreeHeap;									//!< Lowest free heap seen (bytes, during calls with UMM_STATS_FULL, else at entry or exit)
+};
+
+/*!
+	\struct A6dedupEntry
+	\brief	Recently received message
+*/
+struct A6dedupEntry {
+	uint32_t hash;											//!< Hash of sender, time stamp and user data
+	unsigned long time;										//!< Reception time (ms, 0 if unused)
+};
 
 // Class definition
 class FF_A6lib {
@@ -46,11 +201,40 @@ public:
 
 		This class allows asynchronously sending/receiving SMS using an A6 or GA6 (and probably others) modem using PDU mode.
 
-		Messages are in UTF-8 format and automatically converted into GSM7 (160 characters) or UCS-2 (70 characters).
+		Messages are in UTF-8 format and automatically converted into GSM7 (160 characters) or UCS-2 (70 characters, emoji using 2 of them).
+
+		GSM7 messages may use Turkish, Spanish or Portuguese national language tables, keeping more messages out of UCS-2.
 
 		A callback routine in your program will be called each time a SMS is received.
 
-		You also may send SMS directly.
+		Binary data may also be sent and received as 8 bits SMS, with optional application port addressing.
+
+		Messages may also be queued (from several parts of your program), and are sent by doLoop as soon as modem is idle.
+
+		Received commands may be dispatched to handlers by keyword (see FF_A6router).
+
+		Status, counters, queue and history may be written as JSON to any Print or chunked HTTP response (see writeJson).
+
+		Last sent and received messages are kept in bounded histories, that can be browsed (see getSentHistory and getReceivedHistory).
+			All of them may also be kept in a persistent log, queryable by time range and phone number (see FF_A6log).
+
+		Received messages may be filtered by an allow list of senders, and sent ones by a block list of opted-out numbers (see FF_A6numberSet).
+
+		Multi-part messages use 8 or 16 bits references, allocated per destination and optionally persisted in a file (see setReferenceStore).
+
+		An optional idle heartbeat (AT) detects a hung modem before next message, asking for a restart (see setHeartbeat).
+
+		Command timeouts may also be derived from observed answer latency of each command (see setAdaptiveTimeouts).
+
+		When modem hangs, recover() may replace begin(), escalating from a new initialization to a reset pulse,
+			then to a power cycle, if a power driver is given (see FF_A6powerDriver). Recovery time is recorded per method.
+
+		SCA (service center) number may be saved per SIM card, to be reused at next start, and only checked once modem is idle (see setScaStore),
+			or left to modem, sending shorter PDUs (see setModemSca).
+
+		Machine generated messages may be sent compressed with a static dictionary (see FF_A6compress), and are decompressed on reception.
+
+		You also may send SMS directly, or from compile-time templates (see FF_A6template).
 
 		By default, logging/debugging is done through FF_TRACE macros, allowing to easily change code.
 
@@ -72,9 +256,61 @@ public:
 	void begin(long baudRate, int8_t rxPin, int8_t txPin);
 	void doLoop(void);
 	void debugState(void);
+	void writeJson(Print& output, const uint8_t sections = A6_JSON_ALL);
+	void writeJson(void (*chunkCallback)(const char* data, const size_t length), const uint8_t sections = A6_JSON_ALL);
 	void sendSMS(const char* number, const char* text);
+	void sendTemplate(const char* number, const A6templateView& tpl, const char* const* fields, const uint8_t fieldCount);
+
+	/*!
+
+		\brief	Sends a message built from a compile-time template
+
+		\param[in]	number: phone number to send message to
+		\param[in]	tpl: template to send
+		\param[in]	fields: fields to put in place of placeholders
+		\return	none
+
+	*/
+	template <size_t N, typename... Fields>
+	void sendTemplate(const char* number, const FF_A6template<N>& tpl, Fields... fields) {
+		const char* values[] = {fields..., NULL};
+		sendTemplate(number, tpl.view(), values, sizeof...(fields));
+	}
+
+	void sendBinary(const char* number, const uint8_t* data, const uint16_t len, const uint16_t destinationPort = 0, const uint16_t sourcePort = 0);
+	void sendCompressed(const char* number, const char* text);
+	bool queueSMS(const char* number, const char* text);
+	bool queueBinary(const char* number, const uint8_t* data, const uint16_t len, const uint16_t destinationPort = 0, const uint16_t sourcePort = 0);
+	bool queueCompressed(const char* number, const char* text);
+	uint16_t getQueueCount(void);
+	void setDedupWindow(const uint16_t seconds);
+	void setRouter(FF_A6router* commandRouter);
+	void setLog(FF_A6log* log);
+	void setAllowList(FF_A6numberSet* numbers);
+	void setBlockList(FF_A6numberSet* numbers);
+	void setTimeSource(uint32_t (*timeSource)(void));
+	void setTime(const uint32_t epoch);
+	void setModemClock(const bool enabled);
+	void setModemSca(const bool enabled);
+	void setTimeZone(const int16_t minutes);
+	uint32_t getEpoch(void);
+	const unsigned long* getDelayHistogram(void);
+	unsigned long getDelayUnknownCount(void);
+	const A6perfStats& getPerfStats(void);
+	void resetPerfStats(void);
+	void setPowerDriver(FF_A6powerDriver* driver);
+	void recover(void);
+	const A6recoveryStats& getRecoveryStats(const uint8_t method);
+	void setHeartbeat(const uint16_t interval);
+	void setAdaptiveTimeouts(const unsigned long floor, const unsigned long ceiling);
+	const A6latency& getLatency(const uint8_t slot);
+	#ifdef FF_A6LIB_HEAP_STATS
+		const A6heapStats& getHeapStats(const uint8_t operation);
+	#endif
 	void sendOneSmsChunk(const char* number, const char* text, const unsigned short msgId = 0, const unsigned char msgCount = 0, const unsigned char msgIndex = 0);
 	void registerSmsCb(void (*readSmsCallback)(int __index, const char* __number, const char* __date, const char* __message));
+	void registerTimedSmsCb(void (*readTimedSmsCallback)(int __index, const char* __number, const uint32_t __sentTime, const uint32_t __receivedTime, const char* __message));
+	void registerBinaryCb(void (*readBinaryCallback)(int __index, const char* __number, const char* __date, const uint8_t* __data, const uint16_t __length, const uint16_t __port));
 	void registerLineCb(void (*recvLineCallback)(const char* __answer));
 	void deleteSMS(int index, int flag);
 	void sendAT(const char* command);
@@ -91,8 +327,16 @@ public:
 	const char* getLastSentNumber(void);
 	const char* getLastSentDate(void);
 	const char* getLastSentMessage(void);
+	FF_A6history& getSentHistory(void);
+	FF_A6history& getReceivedHistory(void);
 	uint8_t getGsm7EquivalentLen(const uint8_t c1, const uint8_t c2, const uint8_t c3);
 	uint16_t ucs2MessageLength(const char* text);
+	A6messagePlan planMessage(const char* text);
+	void setTransliteration(const bool enabled);
+	uint16_t getLastTransliterationSaving(void);
+	void setConcatReferenceBits(const uint8_t bits);
+	bool setReferenceStore(FS& fs, const char* path);
+	bool setScaStore(FS& fs, const char* path);
 
 	// Public variables
 	bool debugFlag;											//!< Show debug messages flag
@@ -107,25 +351,64 @@ private:
 	void waitMillis(unsigned long waitMs, void (FF_A6lib::*nextStep)(void)=NULL);
 	void waitSmsReady(unsigned long waitMs, void (FF_A6lib::*nextStep)(void)=NULL);
 	void sendNextSmsChunk(void);
+	uint16_t selectAlphabet(const char* text, const uint16_t utf8Length);
+	void sendSavedMessage(const char* number, char* message, uint16_t utf8Length, uint16_t segments, const char* original);
+	void sendTextChunk(const char* number, const char* text, const uint16_t startPos, const uint16_t endPos, const unsigned short msgId, const unsigned char msgCount, const unsigned char msgIndex);
+	bool queuePush(const uint8_t type, const char* number, const uint8_t* data, const uint16_t len, const uint16_t destinationPort, const uint16_t sourcePort);
+	void sendQueued(void);
+	void powerStep(void);
+	void gotPowerProbe(void);
+	uint8_t recoveryMethodAt(const uint8_t attempts);
+	void heartbeat(void);
+	void gotHeartbeat(void);
+	unsigned long heartbeatDelay(void);
+	unsigned long commandTimeout(const char* command, const unsigned long defaultTimeout);
+	void recordLatency(const unsigned long latency);
+	void writeJsonContent(FF_A6json& json, const uint8_t sections);
+	void writeJsonHistory(FF_A6json& json, const char* key, FF_A6history& history);
+	void sendBinaryBuffer(const char* number, const uint16_t len, const uint16_t destinationPort, const uint16_t sourcePort, const char* message);
+	void sendBinaryChunk(const char* number, const uint16_t startPos, const uint16_t endPos, const unsigned short msgId, const unsigned char msgCount, const unsigned char msgIndex);
+	void sendPdu(const int len, const char* pdu);
 	void openModem(long baudRate);
 	void setReset(void);
 	void echoOff(void);
 	void detailedErrors(void);
 	void setCallerId(void);
 	void setTextMode(void);
+	void readIccid(void);
+	void gotIccid(void);
 	void getSca(void);
 	void gotSca(void);
+	bool parseSca(char* scaNumber);
+	void checkSca(void);
+	void gotCheckedSca(void);
+	bool loadSca(void);
+	void saveSca(void);
 	void setHeaderDetails(void);
 	void waitUntilSmsReady(void);
 	void setIndicOff(void);
 	void detailedRegister(void);
 	void deleteReadSent(void);
+	void enableNetworkTime(void);
+	void readModemClock(void);
+	void gotModemClock(void);
 	void initComplete(void);
 	void sendSMStext(void);
 	void setIdle(void);
 	void enterRoutine(const char* routineName);
 	void readSmsHeader(const char* msg);
 	void readSmsMessage(const char* msg);
+	void readBinaryMessage(const A6deliver& deliver);
+	bool isDuplicate(const A6deliver* deliver, const char* pdu);
+	bool senderAllowed(const char* sender);
+	bool destinationAllowed(const char* number);
+	bool setDestination(const char* number);
+	void notifySms(const char* sender, const char* date, const char* message, const uint8_t* timeStamp);
+	uint32_t recordDelay(const uint8_t* timeStamp);
+	uint8_t concatUdhLen(void);
+	uint16_t nextConcatReference(const char* number);
+	uint16_t reserveReferences(void);
+	static uint32_t fnvHash(const void* data, const size_t len, uint32_t hash = 2166136261UL);
 	void resetLastAnswer(void);
 
 	// Private variables
@@ -136,11 +419,33 @@ private:
 	unsigned int smsReadCount;								//!< Count of SMS read
 	unsigned int smsForwardedCount;							//!< Count of SMS analyzed
 	unsigned int smsSentCount;								//!< Count of SMS sent
+	unsigned int transliterationSavedCount;					//!< Count of SMS saved by transliteration
 	int8_t modemRxPin;										//!< Modem RX pin
 	int8_t modemTxPin;										//!< Modem TX pin
+	long modemBaudRate;										//!< Modem speed given to begin
+	FF_A6powerDriver* powerDriver;							//!< Modem power control (NULL if none)
+	uint8_t powerState;										//!< Current step of reset or power cycle (A6_POWER_IDLE if none)
+	unsigned long powerStepTime;							//!< Start of current power step (ms)
+	uint8_t recoveryMethod;									//!< Method of running recovery (A6_RECOVER_NONE if none)
+	uint8_t recoveryAttempts;								//!< Count of failed recoveries since modem was last ready
+	unsigned long recoveryStartTime;						//!< Start of running recovery (ms)
+	A6recoveryStats recoveryStats[A6_RECOVER_METHODS];		//!< Counters of each recovery method
+	uint16_t heartbeatInterval;								//!< Longest interval between idle heartbeats (s, 0 if disabled)
+	unsigned long heartbeatTime;							//!< Time modem was last seen alive (ms)
+	uint8_t heartbeatHistory;								//!< Results of last 8 heartbeats (one bit set per failure)
+	uint8_t heartbeatMisses;								//!< Count of consecutive missed heartbeats
+	unsigned int heartbeatCount;							//!< Count of heartbeats sent
+	unsigned int heartbeatFailCount;						//!< Count of missed heartbeats
+	bool backgroundCheck;									//!< Current command is a background check, its errors and time out don't ask for restart
+	unsigned long timeoutFloor;								//!< Shortest adaptive timeout (ms)
+	unsigned long timeoutCeiling;							//!< Longest adaptive timeout (ms, 0 if timeouts are not adaptive)
+	A6latency latencies[A6_LATENCY_SLOTS];					//!< Observed latency of commands
+	uint8_t latencySlot;									//!< Latency slot of running command (A6_LATENCY_NONE if none)
 	bool smsReady;											//!< True if "SMS ready" seen
 	void (FF_A6lib::*nextStepCb)(void);						//!< Callback for next step in command execution
 	void (*readSmsCb)(int __index, const char* __number, const char* __date, const char* __message); //!< Callback for readSMS
+	void (*readTimedSmsCb)(int __index, const char* __number, const uint32_t __sentTime, const uint32_t __receivedTime, const char* __message); //!< Callback for readSMS, with times
+	void (*readBinaryCb)(int __index, const char* __number, const char* __date, const uint8_t* __data, const uint16_t __length, const uint16_t __port); //!< Callback for binary SMS
 	void (*recvLineCb)(const char* __answer);				//!< Callback for received line
 	int index;												//!< Index of last read SMS
 	int restartReason;										//!< Last restart reason
@@ -155,16 +460,74 @@ private:
 	char lastAnswer[MAX_ANSWER];							//!< Contains the last GSM command anwser
 	char expectedAnswer[10];								//!< Expected answer to consider command ended
 	char lastCommand[30];									//!< Last command sent
-	uint16_t gsm7Length;									//!< Size of GSM-7 message (0 for UCS-2 messages)
+	uint8_t smsDcs;											//!< Data coding scheme of message being sent (A6_DCS_GSM7, A6_DCS_UCS2 or A6_DCS_8BIT)
+	uint8_t smsLockingShift;								//!< GSM-7 locking shift table of message being sent
+	uint8_t smsSingleShift;									//!< GSM-7 single shift table of message being sent
+	bool transliterateFlag;									//!< Transliterate characters outside default GSM-7 tables
+	uint16_t lastTransliterationSaving;						//!< Count of SMS saved by transliteration of last sent message
 	unsigned short smsMsgId;								//!< Multi-part message ID (to be incremented for each multi-part message sent)
 	uint8_t smsMsgIndex;									//!< Chunk index of current multi-part message
 	uint8_t smsMsgCount;									//!< Chunk total count of current multi-part message
 	uint8_t smsChunkSize;									//!< Chunk size for this message
-	String lastReceivedNumber;								//!< Phone number of last received SMS
-	String lastReceivedDate;								//!< Date of last received SMS
-	String lastReceivedMessage;								//!< Message of last received SMS
-	String lastSentNumber;									//!< Phone number of last SMS sent
-	String lastSentDate;									//!< Date of last SMS sent
-	String lastSentMessage;									//!< Message of last SMS sent
+	uint8_t smsAddress[A6_PDU_ADDRESS_LEN];					//!< Encoded destination address of this message
+	uint16_t smsChunkStart;									//!< Start position (bytes) of next chunk in message
+	const char* smsPduText;									//!< Hex encoded PDU of chunk being sent
+	uint8_t binaryData[A6_MAX_BINARY_LEN];					//!< Binary data being sent
+	uint16_t binaryLength;									//!< Length of binary data being sent
+	uint16_t binaryDestinationPort;							//!< Destination port of binary data being sent
+	uint16_t binarySourcePort;								//!< Source port of binary data being sent
+	uint8_t binaryRecvBuffer[A6_MAX_BINARY_LEN];			//!< Binary data being reassembled
+	char binaryRecvSender[A6_PDU_MAX_NUMBER];				//!< Sender of binary data being reassembled
+	char textBuffer[A6_MAX_TEXT_LEN + 1];					//!< Decompressed text of received message, or copy of message resent from history
+	uint16_t binaryRecvReference;							//!< Concatenation reference of binary data being reassembled
+	uint8_t binaryRecvCount;								//!< Chunk count of binary data being reassembled (0 if none)
+	uint32_t binaryRecvMask;								//!< Received chunks of binary data being reassembled (one bit per chunk)
+	uint16_t binaryRecvLength;								//!< Length of binary data being reassembled
+	bool concatReference16;									//!< Use 16 bits concatenated message references
+	uint16_t referenceCounter;								//!< End of last reserved block of references
+	FS* referenceFs;										//!< File system used to persist reference counter (NULL if none)
+	char referenceFile[A6_REFERENCE_PATH_LEN];				//!< File used to persist reference counter
+	A6referenceEntry referenceTable[A6_REFERENCE_DESTINATIONS];	//!< Blocks of references reserved for recent destinations
+	FS* scaFs;												//!< File system used to persist SCA numbers (NULL if none)
+	char scaFile[A6_SCA_PATH_LEN];							//!< File used to persist SCA numbers
+	char iccid[A6_ICCID_LEN];								//!< SIM card identifier (empty if unknown)
+	char currentSca[MAX_SMS_NUMBER_LEN];					//!< SCA number in use
+	bool scaCheckNeeded;									//!< True if SCA loaded from store should be checked against modem
+	uint8_t queueArena[A6_QUEUE_SIZE];						//!< Outbound queue records
+	uint16_t queueHead;										//!< Offset of first queued record
+	uint16_t queueTail;										//!< Offset after last queued record
+	uint16_t queueCount;									//!< Count of queued records
+	unsigned int queueDroppedCount;							//!< Count of records refused because queue was full
+	unsigned long beginTime;								//!< Time of last begin (ms)
+	unsigned long messageStartTime;							//!< Time of first chunk of message being sent (ms)
+	unsigned long chunkStartTime;							//!< Time of chunk being sent (ms)
+	bool messageInProgress;									//!< True if a message is being sent
+	A6perfStats perfStats;									//!< Performance counters
+	uint32_t (*timeSourceCb)(void);							//!< Routine giving current time (NULL if none)
+	uint32_t clockBase;										//!< Time set by setTime or modem (0 if unknown)
+	unsigned long clockBaseMillis;							//!< Value of millis() when clockBase was set
+	bool modemClockFlag;									//!< Read modem clock at end of initialization
+	bool modemScaFlag;										//!< Send PDUs with empty SMSC field, letting modem use its own SCA
+	int16_t timeZone;										//!< Time zone of gateway clock (minutes east of UTC)
+	unsigned long delayHistogram[A6_DELAY_BUCKETS];			//!< Histogram of delays between service center and gateway
+	unsigned long delayUnknownCount;						//!< Count of messages with unknown delay
+	A6dedupEntry dedupCache[A6_DEDUP_SIZE];					//!< Recently received messages
+	uint8_t dedupNext;										//!< Next entry to use in dedup cache
+	uint16_t dedupWindow;									//!< Duplicate received messages window (s, 0 if disabled)
+	unsigned int duplicateCount;							//!< Count of duplicate messages dropped
+	FF_A6router* router;									//!< Router of received commands (NULL if none)
+	unsigned int routedCount;								//!< Count of messages handled by router
+	FF_A6log* messageLog;									//!< Persistent log of messages (NULL if none)
+	FF_A6numberSet* allowList;								//!< Senders allowed to send messages (NULL if everybody)
+	FF_A6numberSet* blockList;								//!< Destinations messages should never be sent to (NULL if none)
+	unsigned int droppedInboundCount;						//!< Count of messages dropped as sender not in allow list
+	unsigned int suppressedOutboundCount;					//!< Count of messages not sent as destination in block list
+	#ifdef FF_A6LIB_HEAP_STATS
+		A6heapStats heapStats[A6_HEAP_OPERATIONS];			//!< Heap accounting of main operations
+	#endif
+	FF_A6history receivedHistory;							//!< Last received SMS
+	FF_A6history sentHistory;								//!< Last sent SMS (newest one is also the message being sent)
+	char lastReceivedDate[A6_DATE_LEN];						//!< Formatted date of last received SMS
+	char lastSentDate[A6_DATE_LEN];							//!< Formatted date of last SMS sent
 };
 #endif
\ No newline at end of file
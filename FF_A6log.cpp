@@ -0,0 +1,456 @@
+/*!
+	\file
+	\brief	Persistent append-only log of sent and received messages, used by FF_A6lib
+	\author	Flying Domotic
+	\date	October 17th, 2026
+*/
+
+#include <FF_A6log.h>
+#include <FF_A6numberSet.h>
+
+// Class constructor : init some variables
+FF_A6log::FF_A6log() {
+	logFs = NULL;
+	directory[0] = 0;
+	path[0] = 0;
+	memset(&current, 0, sizeof(current));
+	bufferLen = 0;
+	bufferTime = 0;
+	lastTime = 0;
+	lostCount = 0;
+}
+
+/*!
+
+	\brief	Open log
+
+	Existing segments are kept, writing continues in the newest one.
+
+	\param[in]	fs: file system to use (LittleFS, SPIFFS...)
+	\param[in]	logDirectory: directory holding log files
+	\return	true if log is usable, false else
+
+*/
+bool FF_A6log::begin(FS& fs, const char* logDirectory) {
+	if (strlen(logDirectory) >= sizeof(directory)) {
+		return false;
+	}
+	logFs = &fs;
+	strncpy(directory, logDirectory, sizeof(directory));
+	if (!logFs->exists(directory)) {
+		logFs->mkdir(directory);
+	}
+	// Look for newest segment
+	A6logSegment segment;
+	memset(&current, 0, sizeof(current));
+	for (uint8_t slot = 0; slot < A6_LOG_SEGMENTS; slot++) {
+		if (readSegment(slot, segment) && segment.sequence > current.sequence) {
+			current = segment;
+		}
+	}
+	if (!current.sequence) {
+		if (!startSegment(1)) {
+			logFs = NULL;
+			return false;
+		}
+	}
+	lastTime = current.lastTime;
+	return true;
+}
+
+/*!
+
+	\brief	Append a message to log
+
+	Record is kept in RAM, and written later by loop() (or now, if buffer is full).
+		Time is never lower than previous record one (clock may be set back), as queries rely on records being sorted by time.
+
+	\param[in]	time: log time (local time, seconds since 01/01/1970)
+	\param[in]	direction: A6_LOG_SENT or A6_LOG_RECEIVED
+	\param[in]	number: phone number
+	\param[in]	message: message (UTF-8)
+	\param[in]	length: message length (bytes, truncated to A6_LOG_MAX_MESSAGE)
+	\return	true if message has been logged, false else
+
+*/
+bool FF_A6log::append(const uint32_t time, const uint8_t direction, const char* number, const char* message, uint16_t length) {
+	if (!logFs) {
+		return false;
+	}
+	uint8_t numberLen = strnlen(number, A6_LOG_MAX_NUMBER);
+	if (length > A6_LOG_MAX_MESSAGE) {
+		length = A6_LOG_MAX_MESSAGE;
+		while (length && (message[length] & 0xC0) == 0x80) {	// Don't split an UTF-8 character
+			length--;
+		}
+	}
+	uint16_t recordLen = A6_LOG_HEADER_LEN + numberLen + length;
+	if (time > lastTime) {
+		lastTime = time;
+	}
+	if (bufferLen + recordLen > sizeof(buffer)) {
+		flush();
+	}
+	if (!bufferLen) {
+		bufferTime = millis();
+	}
+	uint8_t* record = buffer + bufferLen;
+	record[0] = A6_LOG_MARKER;
+	record[1] = direction;
+	record[2] = numberLen;
+	memcpy(record + 3, &length, sizeof(length));
+	memcpy(record + 5, &lastTime, sizeof(lastTime));
+	memcpy(record + A6_LOG_HEADER_LEN, number, numberLen);
+	memcpy(record + A6_LOG_HEADER_LEN + numberLen, message, length);
+	bufferLen += recordLen;
+	return true;
+}
+
+/*!
+
+	\brief	Write buffered records when needed
+
+	Should be called regularly, ideally when nothing else is running (FF_A6lib calls it when modem is idle).
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6log::loop(void) {
+	if (bufferLen && (bufferLen >= sizeof(buffer) / 2 || millis() - bufferTime >= A6_LOG_FLUSH_DELAY)) {
+		flush();
+	}
+}
+
+/*!
+
+	\brief	Write buffered records to segment files
+
+	Records are written first, then segment description, which gives size of valid records.
+		A new segment is started (removing oldest one) when current one is full.
+
+	\param	none
+	\return	true if all records have been written, false else
+
+*/
+bool FF_A6log::flush(void) {
+	if (!logFs || !bufferLen) {
+		return true;
+	}
+	bool ok = true;
+	uint16_t pos = 0;
+	while (pos < bufferLen) {
+		uint8_t* record = buffer + pos;
+		uint16_t length;
+		memcpy(&length, record + 3, sizeof(length));
+		uint16_t recordLen = A6_LOG_HEADER_LEN + record[2] + length;
+		if (current.recordCount && current.size + recordLen > A6_LOG_SEGMENT_SIZE) {	// Segment is full
+			ok &= writeSegment();
+			ok &= startSegment(current.sequence + 1);
+		}
+		if (writeRecord(record, recordLen)) {
+			uint32_t time;
+			memcpy(&time, record + 5, sizeof(time));
+			uint8_t packed[A6_PACKED_NUMBER_LEN];
+			char number[A6_LOG_MAX_NUMBER + 1];
+			memcpy(number, record + A6_LOG_HEADER_LEN, record[2]);
+			number[record[2]] = 0;
+			if (FF_A6numberSet::pack(number, packed)) {
+				bloomAdd(current.bloom, packed);
+			}
+			if (!current.recordCount) current.firstTime = time;
+			if (time > current.lastTime) current.lastTime = time;
+			current.size += recordLen;
+			current.recordCount++;
+		} else {
+			lostCount++;
+			ok = false;
+		}
+		pos += recordLen;
+	}
+	bufferLen = 0;
+	ok &= writeSegment();
+	return ok;
+}
+
+/*!
+
+	\brief	Look for logged messages
+
+	\param[in]	from: start of time range (local time, seconds since 01/01/1970)
+	\param[in]	to: end of time range (included)
+	\param[in]	number: phone number to look for (NULL for all numbers)
+	\param[in]	callback: routine called with each matching message, oldest first
+	\return	Count of matching messages
+
+*/
+uint16_t FF_A6log::query(const uint32_t from, const uint32_t to, const char* number, void (*callback)(const A6logRecord& record)) {
+	uint8_t packed[A6_PACKED_NUMBER_LEN];
+	if (!logFs || (number && !FF_A6numberSet::pack(number, packed))) {
+		return 0;
+	}
+	flush();												// Make buffered records visible
+	uint16_t matchCount = 0;
+	uint32_t sequence = (current.sequence > A6_LOG_SEGMENTS) ? current.sequence - A6_LOG_SEGMENTS + 1 : 1;
+	A6logSegment segment;
+	for (; sequence <= current.sequence; sequence++) {
+		if (sequence == current.sequence) {
+			segment = current;
+		} else if (!readSegment(sequence % A6_LOG_SEGMENTS, segment) || segment.sequence != sequence) {
+			continue;
+		}
+		if (!segment.recordCount || segment.lastTime < from || segment.firstTime > to) {
+			continue;										// Segment outside time range
+		}
+		if (number && !bloomContains(segment.bloom, packed)) {
+			continue;										// Number not in segment
+		}
+		matchCount += querySegment(segment, from, to, number ? packed : NULL, callback);
+	}
+	return matchCount;
+}
+
+/*!
+
+	\brief	Return count of records lost due to write errors
+
+	\param	none
+	\return	Count of lost records
+
+*/
+uint16_t FF_A6log::getLostCount(void) {
+	return lostCount;
+}
+
+/*!
+
+	\brief	[Private] Start a new (empty) segment
+
+	\param[in]	sequence: segment sequence number (replaces segment A6_LOG_SEGMENTS before)
+	\return	true if segment has been created, false else
+
+*/
+bool FF_A6log::startSegment(const uint32_t sequence) {
+	memset(&current, 0, sizeof(current));
+	current.sequence = sequence;
+	segmentPath(sequence, "log");
+	File file = logFs->open(path, "w");
+	if (!file) {
+		return false;
+	}
+	file.close();
+	segmentPath(sequence, "idx");
+	file = logFs->open(path, "w");
+	if (!file) {
+		return false;
+	}
+	bool ok = file.write((const uint8_t*) &current, sizeof(current)) == sizeof(current);
+	file.close();
+	return ok;
+}
+
+/*!
+
+	\brief	[Private] Read segment description from its index file
+
+	\param[in]	sequence: segment sequence number (or slot)
+	\param[out]	segment: segment description
+	\return	true if segment exists, false else
+
+*/
+bool FF_A6log::readSegment(const uint32_t sequence, A6logSegment& segment) {
+	segmentPath(sequence, "idx");
+	if (!logFs->exists(path)) {
+		return false;
+	}
+	File file = logFs->open(path, "r");
+	if (!file) {
+		return false;
+	}
+	bool ok = file.read((uint8_t*) &segment, sizeof(segment)) == sizeof(segment);
+	file.close();
+	return ok;
+}
+
+/*!
+
+	\brief	[Private] Write description of current segment in its index file
+
+	\param	none
+	\return	true if description has been written, false else
+
+*/
+bool FF_A6log::writeSegment(void) {
+	segmentPath(current.sequence, "idx");
+	File file = logFs->open(path, "r+");
+	if (!file) {
+		return false;
+	}
+	bool ok = file.write((const uint8_t*) &current, sizeof(current)) == sizeof(current);
+	file.close();
+	return ok;
+}
+
+/*!
+
+	\brief	[Private] Write a record at end of current segment, adding a time index entry if needed
+
+	\param[in]	record: record to write
+	\param[in]	recordLen: record length
+	\return	true if record has been written, false else
+
+*/
+bool FF_A6log::writeRecord(const uint8_t* record, const uint16_t recordLen) {
+	segmentPath(current.sequence, "log");
+	File file = logFs->open(path, "r+");
+	if (!file) {
+		return false;
+	}
+	file.seek(current.size, SeekSet);						// Skip anything written after last saved description
+	bool ok = file.write(record, recordLen) == recordLen;
+	file.close();
+	if (ok && !(current.recordCount % A6_LOG_INDEX_STEP)) {	// Add a time index entry
+		A6logIndexEntry entry;
+		memcpy(&entry.time, record + 5, sizeof(entry.time));
+		entry.offset = current.size;
+		segmentPath(current.sequence, "idx");
+		file = logFs->open(path, "r+");
+		if (file) {
+			file.seek(sizeof(A6logSegment) + (current.recordCount / A6_LOG_INDEX_STEP) * sizeof(entry), SeekSet);
+			file.write((const uint8_t*) &entry, sizeof(entry));
+			file.close();
+		}
+	}
+	return ok;
+}
+
+/*!
+
+	\brief	[Private] Look for logged messages in a segment
+
+	Time index is used to skip records logged before start of time range.
+
+	\param[in]	segment: segment description
+	\param[in]	from: start of time range (local time, seconds since 01/01/1970)
+	\param[in]	to: end of time range (included)
+	\param[in]	packed: packed phone number to look for (NULL for all numbers)
+	\param[in]	callback: routine called with each matching message
+	\return	Count of matching messages
+
+*/
+uint16_t FF_A6log::querySegment(const A6logSegment& segment, const uint32_t from, const uint32_t to, const uint8_t* packed, void (*callback)(const A6logRecord& record)) {
+	// Find last indexed record before start of time range
+	uint32_t offset = 0;
+	segmentPath(segment.sequence, "idx");
+	File file = logFs->open(path, "r");
+	if (file) {
+		A6logIndexEntry entry;
+		file.seek(sizeof(A6logSegment), SeekSet);
+		for (uint16_t i = 0; i <= (segment.recordCount - 1) / A6_LOG_INDEX_STEP; i++) {
+			if (file.read((uint8_t*) &entry, sizeof(entry)) != sizeof(entry) || entry.time >= from) break;
+			offset = entry.offset;
+		}
+		file.close();
+	}
+	// Read records
+	uint16_t matchCount = 0;
+	segmentPath(segment.sequence, "log");
+	file = logFs->open(path, "r");
+	if (!file) {
+		return 0;
+	}
+	file.seek(offset, SeekSet);
+	uint8_t header[A6_LOG_HEADER_LEN];
+	while (offset + A6_LOG_HEADER_LEN <= segment.size) {
+		if (file.read(header, sizeof(header)) != sizeof(header) || header[0] != A6_LOG_MARKER || header[2] > A6_LOG_MAX_NUMBER) break;
+		A6logRecord record;
+		record.direction = header[1];
+		memcpy(&record.length, header + 3, sizeof(record.length));
+		memcpy(&record.time, header + 5, sizeof(record.time));
+		if (record.time > to || record.length > A6_LOG_MAX_MESSAGE) break;
+		char* number = readBuffer;
+		char* message = readBuffer + header[2] + 1;
+		if (file.read((uint8_t*) number, header[2]) != header[2]) break;
+		number[header[2]] = 0;
+		if (file.read((uint8_t*) message, record.length) != record.length) break;
+		message[record.length] = 0;
+		offset += A6_LOG_HEADER_LEN + header[2] + record.length;
+		if (record.time < from) continue;
+		if (packed) {
+			uint8_t recordPacked[A6_PACKED_NUMBER_LEN];
+			if (!FF_A6numberSet::pack(number, recordPacked) || memcmp(packed, recordPacked, sizeof(recordPacked))) continue;
+		}
+		record.number = number;
+		record.message = message;
+		matchCount++;
+		if (callback) (*callback)(record);
+	}
+	file.close();
+	return matchCount;
+}
+
+/*!
+
+	\brief	[Private] Build name of a segment file into path
+
+	\param[in]	sequence: segment sequence number (or slot)
+	\param[in]	extension: file extension ("log" or "idx")
+	\return	none
+
+*/
+void FF_A6log::segmentPath(const uint32_t sequence, const char* extension) {
+	snprintf_P(path, sizeof(path), PSTR("%s/%u.%s"), directory, (unsigned int) (sequence % A6_LOG_SEGMENTS), extension);
+}
+
+/*!
+
+	\brief	[Private] Compute hash of a packed phone number (FNV-1a)
+
+	\param[in]	packed: packed phone number
+	\return	Hash value
+
+*/
+uint32_t FF_A6log::numberHash(const uint8_t* packed) {
+	uint32_t hash = 2166136261UL;
+	for (uint8_t i = 0; i < A6_PACKED_NUMBER_LEN; i++) {
+		hash = (hash ^ packed[i]) * 16777619UL;
+	}
+	return hash;
+}
+
+/*!
+
+	\brief	[Private] Add a packed phone number to a bloom filter
+
+	Three bits are set, each taken from a different byte of number hash.
+
+	\param[in]	bloom: bloom filter
+	\param[in]	packed: packed phone number
+	\return	none
+
+*/
+void FF_A6log::bloomAdd(uint8_t* bloom, const uint8_t* packed) {
+	uint32_t hash = numberHash(packed);
+	for (uint8_t i = 0; i < 3; i++) {
+		uint8_t bit = (hash >> (8 * i)) % (A6_LOG_BLOOM_LEN * 8);
+		bloom[bit >> 3] |= 1 << (bit & 7);
+	}
+}
+
+/*!
+
+	\brief	[Private] Check if a packed phone number may be in a bloom filter
+
+	\param[in]	bloom: bloom filter
+	\param[in]	packed: packed phone number
+	\return	false if number is not in filter, true if it may be
+
+*/
+bool FF_A6log::bloomContains(const uint8_t* bloom, const uint8_t* packed) {
+	uint32_t hash = numberHash(packed);
+	for (uint8_t i = 0; i < 3; i++) {
+		uint8_t bit = (hash >> (8 * i)) % (A6_LOG_BLOOM_LEN * 8);
+		if (!(bloom[bit >> 3] & (1 << (bit & 7)))) return false;
+	}
+	return true;
+}
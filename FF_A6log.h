@@ -0,0 +1,129 @@
+/*!
+	\file
+	\brief	Persistent append-only log of sent and received messages, used by FF_A6lib
+	\author	Flying Domotic
+	\date	October 17th, 2026
+
+	Have a look at FF_A6log.cpp for details
+
+*/
+
+#ifndef FF_A6log_h
+#define FF_A6log_h
+
+#include <Arduino.h>
+#include <FS.h>
+
+// Constants
+#ifndef A6_LOG_SEGMENTS
+	#define A6_LOG_SEGMENTS 8								//!< Count of segment files kept (oldest one is removed when a new one is started)
+#endif
+#ifndef A6_LOG_SEGMENT_SIZE
+	#define A6_LOG_SEGMENT_SIZE 16384						//!< Max size of a segment file (bytes)
+#endif
+#ifndef A6_LOG_BUFFER_SIZE
+	#define A6_LOG_BUFFER_SIZE 512							//!< Size of RAM buffer holding records not yet written (bytes)
+#endif
+#define A6_LOG_FLUSH_DELAY 5000								//!< Max time records are kept in RAM buffer (ms)
+#define A6_LOG_INDEX_STEP 16								//!< Count of records between two time index entries
+#define A6_LOG_BLOOM_LEN 32									//!< Length of segment number bloom filter (bytes)
+#define A6_LOG_MAX_NUMBER 20								//!< Max length of logged phone number
+#define A6_LOG_MAX_MESSAGE 320								//!< Max length of logged message (longer ones are truncated)
+#define A6_LOG_HEADER_LEN 9									//!< Length of log record header
+#define A6_LOG_MARKER 0xA6									//!< First byte of each log record
+#define A6_LOG_PATH_LEN 32									//!< Max length of log file names (including final zero)
+
+#define A6_LOG_SENT 0										//!< Record of a sent message
+#define A6_LOG_RECEIVED 1									//!< Record of a received message
+
+/*!
+	\struct A6logRecord
+	\brief	Logged message, as given to query callback (pointers are only valid during callback)
+*/
+struct A6logRecord {
+	uint32_t time;											//!< Log time (local time, seconds since 01/01/1970)
+	uint8_t direction;										//!< A6_LOG_SENT or A6_LOG_RECEIVED
+	const char* number;										//!< Phone number
+	const char* message;									//!< Message (UTF-8)
+	uint16_t length;										//!< Message length (bytes)
+};
+
+/*!
+	\struct A6logSegment
+	\brief	Segment description, saved at beginning of segment index file
+*/
+struct A6logSegment {
+	uint32_t sequence;										//!< Segment sequence number (0 if unused)
+	uint32_t firstTime;										//!< Time of first record
+	uint32_t lastTime;										//!< Time of last record
+	uint32_t size;											//!< Size of valid records in segment file (bytes)
+	uint16_t recordCount;									//!< Count of records in segment
+	uint8_t bloom[A6_LOG_BLOOM_LEN];						//!< Bloom filter of phone numbers in segment
+};
+
+/*!
+	\struct A6logIndexEntry
+	\brief	Sparse time index entry, saved after segment description in index file
+*/
+struct A6logIndexEntry {
+	uint32_t time;											//!< Time of indexed record
+	uint32_t offset;										//!< Offset of indexed record in segment file
+};
+
+class FF_A6log {
+public:
+	/*!	\class FF_A6log
+		\brief Persistent append-only log of sent and received messages
+
+		Records are appended to fixed size segment files (<directory>/<slot>.log), up to A6_LOG_SEGMENTS of them being kept.
+			Each segment has an index file (<directory>/<slot>.idx) with its time range, a bloom filter of its phone numbers
+			and a sparse time index (one entry every A6_LOG_INDEX_STEP records), so queries skip segments and records not matching.
+
+		Appends are buffered in RAM, and written by loop() at most every A6_LOG_FLUSH_DELAY ms (or when half buffer is used).
+
+		\code
+			void printRecord(const A6logRecord& record) {
+				Serial.printf("%lu %s %s: %s\n", record.time, record.direction == A6_LOG_SENT ? "to" : "from", record.number, record.message);
+			}
+			...
+			messageLog.begin(LittleFS, "/a6log");
+			a6.setLog(&messageLog);
+			...
+			messageLog.query(a6.getEpoch() - 86400, a6.getEpoch(), "+33612345678", printRecord);
+		\endcode
+	*/
+	FF_A6log();
+
+	// Public routines (documented in FF_A6log.cpp)
+	bool begin(FS& fs, const char* directory);
+	bool append(const uint32_t time, const uint8_t direction, const char* number, const char* message, uint16_t length);
+	void loop(void);
+	bool flush(void);
+	uint16_t query(const uint32_t from, const uint32_t to, const char* number, void (*callback)(const A6logRecord& record));
+	uint16_t getLostCount(void);
+
+private:
+	// Private routines (documented in FF_A6log.cpp)
+	bool startSegment(const uint32_t sequence);
+	bool readSegment(const uint32_t sequence, A6logSegment& segment);
+	bool writeSegment(void);
+	bool writeRecord(const uint8_t* record, const uint16_t recordLen);
+	uint16_t querySegment(const A6logSegment& segment, const uint32_t from, const uint32_t to, const uint8_t* packed, void (*callback)(const A6logRecord& record));
+	void segmentPath(const uint32_t sequence, const char* extension);
+	static uint32_t numberHash(const uint8_t* packed);
+	static void bloomAdd(uint8_t* bloom, const uint8_t* packed);
+	static bool bloomContains(const uint8_t* bloom, const uint8_t* packed);
+
+	// Private variables
+	FS* logFs;												//!< File system holding log (NULL if not started)
+	char directory[A6_LOG_PATH_LEN - 8];					//!< Log directory
+	char path[A6_LOG_PATH_LEN];								//!< Last built file name
+	A6logSegment current;									//!< Description of segment being written
+	uint8_t buffer[A6_LOG_BUFFER_SIZE];						//!< Records not yet written
+	uint16_t bufferLen;										//!< Length of records not yet written
+	unsigned long bufferTime;								//!< Time of oldest record not yet written (ms)
+	uint32_t lastTime;										//!< Time of last appended record
+	uint16_t lostCount;										//!< Count of records lost due to write errors
+	char readBuffer[A6_LOG_MAX_NUMBER + A6_LOG_MAX_MESSAGE + 2];	//!< Number and message of record being read by query
+};
+#endif
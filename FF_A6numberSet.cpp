@@ -0,0 +1,369 @@
+/*!
+	\file
+	\brief	Compact hashed set of phone numbers, used by FF_A6lib allow and block lists
+	\author	Flying Domotic
+	\date	October 17th, 2026
+*/
+
+#include <FF_A6numberSet.h>
+
+// Class constructor : init some variables
+FF_A6numberSet::FF_A6numberSet() {
+	table = NULL;
+	slotCount = 0;
+	usedCount = 0;
+}
+
+/*!
+
+	\brief	Use a RAM buffer as table
+
+	\param[in]	buffer: buffer to use (capacity * A6_PACKED_NUMBER_LEN bytes, content is kept, so it must be zeroed before first use)
+	\param[in]	capacity: count of slots (a few more than count of numbers to store, to keep lookups short)
+	\return	true if set is usable, false else
+
+*/
+bool FF_A6numberSet::begin(uint8_t* buffer, const uint16_t capacity) {
+	if (!buffer || capacity < 2) {
+		return false;
+	}
+	table = buffer;
+	slotCount = capacity;
+	usedCount = 0;
+	uint8_t data[A6_PACKED_NUMBER_LEN];
+	for (uint16_t i = 0; i < slotCount; i++) {
+		readSlot(i, data);
+		if (!isEmpty(data) && !isDeleted(data)) usedCount++;
+	}
+	return true;
+}
+
+/*!
+
+	\brief	Use a file as table
+
+	File is created if it doesn't exist. An existing file must have been created with same capacity.
+
+	\param[in]	fs: file system to use (LittleFS, SPIFFS...)
+	\param[in]	path: file path
+	\param[in]	capacity: count of slots (a few more than count of numbers to store, to keep lookups short)
+	\return	true if set is usable, false else
+
+*/
+bool FF_A6numberSet::begin(FS& fs, const char* path, const uint16_t capacity) {
+	uint8_t data[A6_PACKED_NUMBER_LEN];
+	if (capacity < 2) {
+		return false;
+	}
+	table = NULL;
+	slotCount = capacity;
+	usedCount = 0;
+	if (!fs.exists(path)) {									// Create an empty table
+		file = fs.open(path, "w");
+		if (!file) {
+			return false;
+		}
+		memset(data, 0, sizeof(data));
+		for (uint16_t i = 0; i < slotCount; i++) {
+			file.write(data, sizeof(data));
+		}
+		file.close();
+	}
+	file = fs.open(path, "r+");
+	if (!file || file.size() != (size_t) slotCount * A6_PACKED_NUMBER_LEN) {
+		if (file) file.close();
+		slotCount = 0;
+		return false;
+	}
+	for (uint16_t i = 0; i < slotCount; i++) {
+		readSlot(i, data);
+		if (!isEmpty(data) && !isDeleted(data)) usedCount++;
+	}
+	return true;
+}
+
+/*!
+
+	\brief	Add a number to set
+
+	\param[in]	number: phone number
+	\return	true if number is in set, false if number is invalid or set is full
+
+*/
+bool FF_A6numberSet::add(const char* number) {
+	uint8_t packed[A6_PACKED_NUMBER_LEN];
+	int32_t freeSlot;
+	if (!pack(number, packed)) {
+		return false;
+	}
+	if (find(packed, &freeSlot) >= 0) {
+		return true;										// Already there
+	}
+	if (freeSlot < 0 || usedCount >= slotCount - 1) {		// Keep at least one empty slot to end lookups
+		return false;
+	}
+	writeSlot(freeSlot, packed);
+	usedCount++;
+	return true;
+}
+
+/*!
+
+	\brief	Remove a number from set
+
+	\param[in]	number: phone number
+	\return	true if number has been removed, false if it was not in set
+
+*/
+bool FF_A6numberSet::remove(const char* number) {
+	uint8_t packed[A6_PACKED_NUMBER_LEN];
+	if (!pack(number, packed)) {
+		return false;
+	}
+	int32_t slot = find(packed, NULL);
+	if (slot < 0) {
+		return false;
+	}
+	removeSlot(slot);
+	usedCount--;
+	return true;
+}
+
+/*!
+
+	\brief	Check if a number is in set
+
+	\param[in]	number: phone number
+	\return	true if number is in set
+
+*/
+bool FF_A6numberSet::contains(const char* number) {
+	uint8_t packed[A6_PACKED_NUMBER_LEN];
+	if (!slotCount || !pack(number, packed)) {
+		return false;
+	}
+	return find(packed, NULL) >= 0;
+}
+
+/*!
+
+	\brief	Remove all numbers from set
+
+	\param	none
+	\return	none
+
+*/
+void FF_A6numberSet::clear(void) {
+	uint8_t data[A6_PACKED_NUMBER_LEN];
+	memset(data, 0, sizeof(data));
+	for (uint16_t i = 0; i < slotCount; i++) {
+		writeSlot(i, data);
+	}
+	usedCount = 0;
+}
+
+/*!
+
+	\brief	Returns count of numbers in set
+
+	\param	none
+	\return	Count of numbers
+
+*/
+uint16_t FF_A6numberSet::count(void) {
+	return usedCount;
+}
+
+/*!
+
+	\brief	Returns count of slots in set
+
+	\param	none
+	\return	Count of slots
+
+*/
+uint16_t FF_A6numberSet::capacity(void) {
+	return slotCount;
+}
+
+/*!
+
+	\brief	Normalize and pack a phone number
+
+	International prefix ("+" or "00") and separators (spaces, dots, dashes, parenthesis) are removed, remaining digits being packed 2 per byte,
+		unused nibbles being set to 0xf.
+
+	\param[in]	number: phone number
+	\param[out]	packed: packed number (A6_PACKED_NUMBER_LEN bytes)
+	\return	true if number is valid (1 to 15 digits), false else
+
+*/
+bool FF_A6numberSet::pack(const char* number, uint8_t* packed) {
+	uint8_t digits = 0;
+	memset(packed, 0xff, A6_PACKED_NUMBER_LEN);
+	if (*number == '+') {
+		number++;
+	} else if (number[0] == '0' && number[1] == '0') {
+		number += 2;
+	}
+	for (; *number; number++) {
+		char c = *number;
+		if (c == ' ' || c == '.' || c == '-' || c == '(' || c == ')') continue;
+		if (c < '0' || c > '9' || digits >= A6_PACKED_NUMBER_LEN * 2 - 1) {
+			return false;
+		}
+		if (digits & 1) {
+			packed[digits / 2] = (packed[digits / 2] & 0xf0) | (c - '0');
+		} else {
+			packed[digits / 2] = ((c - '0') << 4) | 0x0f;
+		}
+		digits++;
+	}
+	return digits != 0;
+}
+
+/*!
+
+	\brief	[Private] Find a packed number in table
+
+	\param[in]	packed: packed number
+	\param[out]	freeSlot: first empty or deleted slot in probe chain (-1 if none), may be NULL
+	\return	Slot of number (-1 if not found)
+
+*/
+int32_t FF_A6numberSet::find(const uint8_t* packed, int32_t* freeSlot) {
+	uint8_t data[A6_PACKED_NUMBER_LEN];
+	if (freeSlot) *freeSlot = -1;
+	uint16_t slot = homeSlot(packed);
+	for (uint16_t i = 0; i < slotCount; i++) {
+		readSlot(slot, data);
+		if (isEmpty(data)) {								// End of probe chain
+			if (freeSlot && *freeSlot < 0) *freeSlot = slot;
+			return -1;
+		}
+		if (isDeleted(data)) {
+			if (freeSlot && *freeSlot < 0) *freeSlot = slot;
+		} else if (!memcmp(data, packed, A6_PACKED_NUMBER_LEN)) {
+			return slot;
+		}
+		slot = (slot + 1 == slotCount) ? 0 : slot + 1;
+	}
+	return -1;
+}
+
+/*!
+
+	\brief	[Private] Empty a slot, moving back following numbers of its probe chain
+
+	Backward shift deletion keeps probe chains short without deleted markers: each following number that could have been stored
+		in emptied slot is moved there, its own slot becoming the one to fill, until an empty slot ends the chain.
+		Deleted markers written by previous versions are left in place (and reused by add).
+
+	\param[in]	slot: slot to empty
+	\return	none
+
+*/
+void FF_A6numberSet::removeSlot(uint16_t slot) {
+	uint8_t data[A6_PACKED_NUMBER_LEN];
+	uint16_t hole = slot;
+	for (uint16_t i = 1; i < slotCount; i++) {
+		slot = (slot + 1 == slotCount) ? 0 : slot + 1;
+		readSlot(slot, data);
+		if (isEmpty(data)) break;							// End of probe chain
+		if (isDeleted(data)) continue;
+		uint16_t home = homeSlot(data);
+		// Number may move back if its home slot is not between hole (excluded) and its current slot (included)
+		bool movable = (hole <= slot) ? (home <= hole || home > slot) : (home <= hole && home > slot);
+		if (movable) {
+			writeSlot(hole, data);
+			hole = slot;
+		}
+	}
+	memset(data, 0, sizeof(data));
+	writeSlot(hole, data);
+}
+
+/*!
+
+	\brief	[Private] Return first slot to probe for a packed number
+
+	\param[in]	packed: packed number
+	\return	Slot index
+
+*/
+uint16_t FF_A6numberSet::homeSlot(const uint8_t* packed) {
+	uint32_t hash = 2166136261UL;							// FNV-1a
+	for (uint8_t i = 0; i < A6_PACKED_NUMBER_LEN; i++) {
+		hash = (hash ^ packed[i]) * 16777619UL;
+	}
+	return hash % slotCount;
+}
+
+/*!
+
+	\brief	[Private] Read a table slot
+
+	\param[in]	slot: slot index
+	\param[out]	data: slot content (A6_PACKED_NUMBER_LEN bytes)
+	\return	none
+
+*/
+void FF_A6numberSet::readSlot(const uint16_t slot, uint8_t* data) {
+	if (table) {
+		memcpy(data, table + (size_t) slot * A6_PACKED_NUMBER_LEN, A6_PACKED_NUMBER_LEN);
+		return;
+	}
+	file.seek((size_t) slot * A6_PACKED_NUMBER_LEN, SeekSet);
+	if (file.read(data, A6_PACKED_NUMBER_LEN) != A6_PACKED_NUMBER_LEN) {
+		memset(data, 0, A6_PACKED_NUMBER_LEN);				// Read error, consider slot as empty
+	}
+}
+
+/*!
+
+	\brief	[Private] Write a table slot
+
+	\param[in]	slot: slot index
+	\param[in]	data: slot content (A6_PACKED_NUMBER_LEN bytes)
+	\return	none
+
+*/
+void FF_A6numberSet::writeSlot(const uint16_t slot, const uint8_t* data) {
+	if (table) {
+		memcpy(table + (size_t) slot * A6_PACKED_NUMBER_LEN, data, A6_PACKED_NUMBER_LEN);
+		return;
+	}
+	file.seek((size_t) slot * A6_PACKED_NUMBER_LEN, SeekSet);
+	file.write(data, A6_PACKED_NUMBER_LEN);
+	file.flush();
+}
+
+/*!
+
+	\brief	[Private] Check if a slot is empty (never used)
+
+	\param[in]	data: slot content
+	\return	true if slot is empty
+
+*/
+bool FF_A6numberSet::isEmpty(const uint8_t* data) {
+	for (uint8_t i = 0; i < A6_PACKED_NUMBER_LEN; i++) {
+		if (data[i]) return false;
+	}
+	return true;
+}
+
+/*!
+
+	\brief	[Private] Check if a slot contains a deleted number
+
+	\param[in]	data: slot content
+	\return	true if slot is deleted
+
+*/
+bool FF_A6numberSet::isDeleted(const uint8_t* data) {
+	for (uint8_t i = 0; i < A6_PACKED_NUMBER_LEN; i++) {
+		if (data[i] != 0xff) return false;
+	}
+	return true;
+}
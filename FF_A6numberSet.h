@@ -0,0 +1,60 @@
+/*!
+	\file
+	\brief	Compact hashed set of phone numbers, used by FF_A6lib allow and block lists
+	\author	Flying Domotic
+	\date	October 17th, 2026
+
+	Have a look at FF_A6numberSet.cpp for details
+
+*/
+
+#ifndef FF_A6numberSet_h
+#define FF_A6numberSet_h
+
+#include <Arduino.h>
+#include <FS.h>
+
+// Constants
+#define A6_PACKED_NUMBER_LEN 8								//!< Length of a packed phone number (up to 15 digits)
+
+class FF_A6numberSet {
+public:
+	/*!	\class FF_A6numberSet
+		\brief Compact hashed set of phone numbers
+
+		Numbers are normalized (international prefix "+" or "00" and separators removed) and packed as BCD digits (8 bytes per number),
+			then stored in an open addressing hash table (linear probing), either in RAM or in a file.
+
+		File backed sets only keep an open file in RAM, so they may hold thousands of numbers, each lookup reading a few slots.
+		Removal moves back following numbers of the probe chain (backward shift), so no deleted marker lengthens lookups.
+	*/
+	FF_A6numberSet();
+
+	// Public routines (documented in FF_A6numberSet.cpp)
+	bool begin(uint8_t* buffer, const uint16_t capacity);
+	bool begin(FS& fs, const char* path, const uint16_t capacity);
+	bool add(const char* number);
+	bool remove(const char* number);
+	bool contains(const char* number);
+	void clear(void);
+	uint16_t count(void);
+	uint16_t capacity(void);
+	static bool pack(const char* number, uint8_t* packed);
+
+private:
+	// Private routines (documented in FF_A6numberSet.cpp)
+	int32_t find(const uint8_t* packed, int32_t* freeSlot);
+	void removeSlot(uint16_t slot);
+	uint16_t homeSlot(const uint8_t* packed);
+	void readSlot(const uint16_t slot, uint8_t* data);
+	void writeSlot(const uint16_t slot, const uint8_t* data);
+	static bool isEmpty(const uint8_t* data);
+	static bool isDeleted(const uint8_t* data);
+
+	// Private variables
+	uint8_t* table;											//!< RAM table (NULL if file backed)
+	File file;												//!< Table file (if file backed)
+	uint16_t slotCount;										//!< Count of slots in table
+	uint16_t usedCount;										//!< Count of numbers in table
+};
+#endif
@@ -0,0 +1,547 @@
+/*!
+	\file
+	\brief	SMS-SUBMIT PDU encoder (and SMS-DELIVER decoder) used by FF_A6lib
+	\author	Flying Domotic
+	\date	October 17th, 2026
+*/
+
+#include <FF_A6pdu.h>
+#include <FF_A6clock.h>
+
+// Class constructor : init some variables
+FF_A6pdu::FF_A6pdu() {
+	memset(pduBuffer, 0, sizeof(pduBuffer));
+	memset(scaField, 0, sizeof(scaField));
+	pduLength = 0;
+	scaFieldLen = 0;
+}
+
+/*!
+
+	\brief	Set SMSC (service center) number to put in PDU
+
+	\param[in]	number: SMSC number (international numbers start with "+"). Empty string lets modem use its default SMSC
+	\return	true if number has been accepted, false else
+
+*/
+bool FF_A6pdu::setScaNumber(const char* number) {
+	if (!number[0]) {										// No number, use modem default
+		scaFieldLen = 0;
+		return true;
+	}
+	uint8_t len = encodeAddress(number, scaField, true);
+	if (!len) {
+		return false;
+	}
+	scaFieldLen = len;
+	return true;
+}
+
+/*!
+
+	\brief	Encode a SMS-SUBMIT PDU
+
+	GSM-7 user data is given as septets (one per byte), packed here after user data header, with needed fill bits.
+	Other alphabets are given as octets.
+
+	\param[in]	number: phone number to send message to
+	\param[in]	dcs: data coding scheme (A6_DCS_GSM7, A6_DCS_8BIT or A6_DCS_UCS2)
+	\param[in]	udh: user data header information elements (without header length), NULL if none
+	\param[in]	udhLen: length of user data header information elements (0 if none)
+	\param[in]	userData: user data septets or octets
+	\param[in]	userDataLen: count of user data septets or octets
+	\return	TPDU length (octets, as used by AT+CMGS, excluding SMSC field) or negative error code
+
+*/
+int FF_A6pdu::encodeSubmit(const char* number, const uint8_t dcs, const uint8_t* udh, const uint8_t udhLen, const uint8_t* userData, const uint8_t userDataLen) {
+	uint8_t address[A6_PDU_ADDRESS_LEN];
+	if (!encodeNumber(number, address)) {
+		return A6_PDU_ADDRESS_FORMAT;
+	}
+	return encodeSubmit(address, dcs, udh, udhLen, userData, userDataLen);
+}
+
+/*!
+
+	\brief	Encode a SMS-SUBMIT PDU to an already encoded destination address
+
+	Avoids encoding destination address again for each chunk of multi-part messages.
+
+	\param[in]	address: destination address field, as given by encodeNumber
+	\param[in]	dcs: data coding scheme (A6_DCS_GSM7, A6_DCS_8BIT or A6_DCS_UCS2)
+	\param[in]	udh: user data header information elements (without header length), NULL if none
+	\param[in]	udhLen: length of user data header information elements (0 if none)
+	\param[in]	userData: user data septets or octets
+	\param[in]	userDataLen: count of user data septets or octets
+	\return	TPDU length (octets, as used by AT+CMGS, excluding SMSC field) or negative error code
+
+*/
+int FF_A6pdu::encodeSubmit(const uint8_t* address, const uint8_t dcs, const uint8_t* udh, const uint8_t udhLen, const uint8_t* userData, const uint8_t userDataLen) {
+	uint8_t addressLen = addressLength(address);
+	if (!addressLen) {
+		return A6_PDU_ADDRESS_FORMAT;
+	}
+	uint16_t udhOctets = udhLen ? udhLen + 1 : 0;			// Header elements plus header length octet
+	bool isGsm7 = ((dcs & 0x0c) == A6_DCS_GSM7);
+	uint8_t fillBits = 0;
+	uint16_t udl;											// User data length (septets for GSM-7, octets else)
+	if (isGsm7) {
+		fillBits = (7 - ((udhOctets * 8) % 7)) % 7;
+		udl = ((udhOctets * 8) + fillBits) / 7 + userDataLen;
+		if (udl > (A6_PDU_MAX_UD * 8) / 7) {
+			return A6_PDU_TOO_LONG;
+		}
+	} else {
+		udl = udhOctets + userDataLen;
+		if (udl > A6_PDU_MAX_UD) {
+			return A6_PDU_TOO_LONG;
+		}
+	}
+
+	pduLength = 0;
+	// SMSC field (a zero length let modem use its default SMSC)
+	if (scaFieldLen) {
+		for (uint8_t i = 0; i < scaFieldLen; i++) {
+			appendHex(scaField[i]);
+		}
+	} else {
+		appendHex(0);
+	}
+	uint16_t tpduStart = pduLength;
+	appendHex(udhLen ? 0x41 : 0x01);						// SMS-SUBMIT, with UDHI bit if needed
+	appendHex(0);											// Message reference (set by modem)
+	for (uint8_t i = 0; i < addressLen; i++) {				// Destination address
+		appendHex(address[i]);
+	}
+	appendHex(0);											// Protocol identifier
+	appendHex(dcs);											// Data coding scheme
+	appendHex(udl);											// User data length
+	if (udhLen) {											// User data header
+		appendHex(udhLen);
+		for (uint8_t i = 0; i < udhLen; i++) {
+			appendHex(udh[i]);
+		}
+	}
+	if (isGsm7) {											// Pack septets
+		uint16_t accumulator = 0;
+		uint8_t bits = fillBits;							// Fill bits are zeros
+		for (uint8_t i = 0; i < userDataLen; i++) {
+			accumulator |= (userData[i] & 0x7f) << bits;
+			bits += 7;
+			if (bits >= 8) {
+				appendHex(accumulator & 0xff);
+				accumulator >>= 8;
+				bits -= 8;
+			}
+		}
+		if (bits) {
+			appendHex(accumulator & 0xff);
+		}
+	} else {
+		for (uint8_t i = 0; i < userDataLen; i++) {
+			appendHex(userData[i]);
+		}
+	}
+	pduBuffer[pduLength] = 0;
+	return (pduLength - tpduStart) / 2;
+}
+
+/*!
+
+	\brief	Return last encoded PDU
+
+	\param	none
+	\return	Hex encoded PDU, ready to be sent after AT+CMGS
+
+*/
+const char* FF_A6pdu::getPdu(void) {
+	return pduBuffer;
+}
+
+/*!
+
+	\brief	Build a concatenated message information element
+
+	\param[out]	udh: buffer to write information element into (at least 6 octets)
+	\param[in]	reference: concatenated message reference
+	\param[in]	count: total count of chunks
+	\param[in]	index: index of this chunk (starting at 1)
+	\param[in]	reference16: use 16 bits reference (IEI 0x08) if true, 8 bits reference (IEI 0x00) else
+	\return	Length of information element
+
+*/
+uint8_t FF_A6pdu::buildConcatUdh(uint8_t* udh, const uint16_t reference, const uint8_t count, const uint8_t index, const bool reference16) {
+	if (!reference16) {
+		udh[0] = A6_IEI_CONCAT_8;
+		udh[1] = 3;
+		udh[2] = reference & 0xff;
+		udh[3] = count;
+		udh[4] = index;
+		return 5;
+	}
+	udh[0] = A6_IEI_CONCAT_16;
+	udh[1] = 4;
+	udh[2] = reference >> 8;
+	udh[3] = reference & 0xff;
+	udh[4] = count;
+	udh[5] = index;
+	return 6;
+}
+
+/*!
+
+	\brief	Build national language shift information elements
+
+	\param[out]	udh: buffer to write information elements into (at least 6 octets)
+	\param[in]	locking: locking shift table (0 for default alphabet)
+	\param[in]	single: single shift table (0 for default extension table)
+	\return	Length of information elements (0 if default tables are used)
+
+*/
+uint8_t FF_A6pdu::buildShiftUdh(uint8_t* udh, const uint8_t locking, const uint8_t single) {
+	uint8_t len = 0;
+	if (locking) {
+		udh[len++] = A6_IEI_LOCKING_SHIFT;
+		udh[len++] = 1;
+		udh[len++] = locking;
+	}
+	if (single) {
+		udh[len++] = A6_IEI_SINGLE_SHIFT;
+		udh[len++] = 1;
+		udh[len++] = single;
+	}
+	return len;
+}
+
+/*!
+
+	\brief	Build an application port addressing information element (16 bits ports)
+
+	\param[out]	udh: buffer to write information element into (at least 6 octets)
+	\param[in]	destinationPort: destination application port
+	\param[in]	sourcePort: source application port
+	\return	Length of information element
+
+*/
+uint8_t FF_A6pdu::buildPortUdh(uint8_t* udh, const uint16_t destinationPort, const uint16_t sourcePort) {
+	udh[0] = A6_IEI_PORT_16;
+	udh[1] = 4;
+	udh[2] = destinationPort >> 8;
+	udh[3] = destinationPort & 0xff;
+	udh[4] = sourcePort >> 8;
+	udh[5] = sourcePort & 0xff;
+	return 6;
+}
+
+/*!
+
+	\brief	Decode a SMS-DELIVER PDU
+
+	This routine extracts sender, time stamp, data coding scheme and user data header informations (concatenation and ports).
+		User data is returned as octets (not decoded).
+
+	\param[in]	pdu: hex encoded PDU, as received from modem
+	\param[out]	deliver: decoded PDU
+	\return	true if PDU has been decoded, false else
+
+*/
+bool FF_A6pdu::decodeDeliver(const char* pdu, A6deliver& deliver) {
+	uint16_t pduLen = strlen(pdu) / 2;
+	uint16_t pos = 0;
+	int16_t value;
+	memset(&deliver, 0, sizeof(deliver));
+
+	#define A6_NEXT_OCTET() if (pos >= pduLen || (value = hexOctet(pdu + 2 * pos++)) < 0) return false;
+	A6_NEXT_OCTET();										// SMSC length
+	pos += value;
+	A6_NEXT_OCTET();										// First octet
+	if (value & 0x03) return false;							// Not a SMS-DELIVER
+	bool hasUdh = value & 0x40;
+	A6_NEXT_OCTET();										// Originating address length (digits)
+	uint8_t digits = value;
+	A6_NEXT_OCTET();										// Type of address
+	uint8_t typeOfAddress = value;
+	uint8_t senderLen = 0;
+	if ((typeOfAddress & 0x70) == 0x50) {					// Alphanumeric sender, coded in GSM-7
+		uint16_t accumulator = 0;
+		uint8_t bits = 0;
+		for (uint8_t i = 0; i < (digits + 1) / 2; i++) {
+			A6_NEXT_OCTET();
+			accumulator |= value << bits;
+			bits += 8;
+			while (bits >= 7 && senderLen < sizeof(deliver.sender) - 1) {
+				uint8_t septet = accumulator & 0x7f;
+				deliver.sender[senderLen++] = (septet >= 0x20 && septet <= 0x7a) ? septet : '?';
+				accumulator >>= 7;
+				bits -= 7;
+			}
+		}
+	} else {
+		if ((typeOfAddress & 0x70) == 0x10) {				// International number
+			deliver.sender[senderLen++] = '+';
+		}
+		for (uint8_t i = 0; i < digits; i++) {
+			if (!(i & 1)) {
+				A6_NEXT_OCTET();
+			}
+			uint8_t digit = (i & 1) ? (value >> 4) : (value & 0x0f);
+			if (senderLen < sizeof(deliver.sender) - 1) {
+				deliver.sender[senderLen++] = (digit < 10) ? '0' + digit : '?';
+			}
+		}
+	}
+	deliver.sender[senderLen] = 0;
+	A6_NEXT_OCTET();										// Protocol identifier
+	A6_NEXT_OCTET();										// Data coding scheme
+	deliver.dcs = value;
+	for (uint8_t i = 0; i < sizeof(deliver.timeStamp); i++) {	// Service center time stamp
+		A6_NEXT_OCTET();
+		deliver.timeStamp[i] = value;
+	}
+	A6_NEXT_OCTET();										// User data length
+	uint16_t udl = value;
+	if (dcsAlphabet(deliver.dcs) == A6_DCS_GSM7) {
+		udl = (udl * 7 + 7) / 8;							// Septets to octets
+	}
+	uint16_t udStart = pos;
+	if (hasUdh) {											// Parse user data header
+		A6_NEXT_OCTET();
+		deliver.udhLen = value;
+		uint16_t udhEnd = pos + deliver.udhLen;
+		while (pos + 1 < udhEnd) {
+			A6_NEXT_OCTET();
+			uint8_t iei = value;
+			A6_NEXT_OCTET();
+			uint8_t ieLen = value;
+			uint8_t ie[6] = {0, 0, 0, 0, 0, 0};
+			for (uint8_t i = 0; i < ieLen; i++) {
+				A6_NEXT_OCTET();
+				if (i < sizeof(ie)) ie[i] = value;
+			}
+			if (iei == A6_IEI_CONCAT_8 && ieLen == 3) {
+				deliver.concatReference = ie[0];
+				deliver.concatCount = ie[1];
+				deliver.concatIndex = ie[2];
+			} else if (iei == A6_IEI_CONCAT_16 && ieLen == 4) {
+				deliver.concatReference = (ie[0] << 8) | ie[1];
+				deliver.concatCount = ie[2];
+				deliver.concatIndex = ie[3];
+			} else if (iei == A6_IEI_PORT_8 && ieLen == 2) {
+				deliver.hasPorts = true;
+				deliver.destinationPort = ie[0];
+				deliver.sourcePort = ie[1];
+			} else if (iei == A6_IEI_PORT_16 && ieLen == 4) {
+				deliver.hasPorts = true;
+				deliver.destinationPort = (ie[0] << 8) | ie[1];
+				deliver.sourcePort = (ie[2] << 8) | ie[3];
+			}
+		}
+		pos = udhEnd;
+	}
+	if (dcsAlphabet(deliver.dcs) == A6_DCS_GSM7) {			// Keep full packed user data
+		pos = udStart;
+	}
+	while (pos < udStart + udl && deliver.userDataLen < sizeof(deliver.userData)) {
+		A6_NEXT_OCTET();
+		deliver.userData[deliver.userDataLen++] = value;
+	}
+	#undef A6_NEXT_OCTET
+	return true;
+}
+
+/*!
+
+	\brief	Return alphabet used by a data coding scheme
+
+	\param[in]	dcs: data coding scheme
+	\return	A6_DCS_GSM7, A6_DCS_8BIT or A6_DCS_UCS2
+
+*/
+uint8_t FF_A6pdu::dcsAlphabet(const uint8_t dcs) {
+	if ((dcs & 0xc0) == 0x00 || (dcs & 0xc0) == 0x40) {		// General data coding (possibly marked for deletion)
+		return ((dcs & 0x0c) == 0x0c) ? A6_DCS_GSM7 : (dcs & 0x0c);
+	}
+	if ((dcs & 0xf0) == 0xf0) {								// Data coding/message class
+		return (dcs & 0x04) ? A6_DCS_8BIT : A6_DCS_GSM7;
+	}
+	if ((dcs & 0xf0) == 0xe0) {								// Message waiting indication, UCS-2
+		return A6_DCS_UCS2;
+	}
+	return A6_DCS_GSM7;
+}
+
+/*!
+
+	\brief	Format a service center time stamp
+
+	\param[in]	timeStamp: service center time stamp (7 raw semi-octets)
+	\param[out]	buffer: buffer to write formatted time stamp into ("yy/MM/dd,hh:mm:ss+zz", zz being in quarters of hour)
+	\param[in]	bufferSize: size of buffer
+	\return	none
+
+*/
+void FF_A6pdu::formatTimeStamp(const uint8_t* timeStamp, char* buffer, const size_t bufferSize) {
+	uint8_t values[7];
+	for (uint8_t i = 0; i < 7; i++) {						// Semi-octets are swapped
+		values[i] = (timeStamp[i] & 0x0f) * 10 + (timeStamp[i] >> 4);
+	}
+	values[6] = (timeStamp[6] & 0x07) * 10 + (timeStamp[6] >> 4);	// Time zone, without sign bit
+	snprintf_P(buffer, bufferSize, PSTR("%02d/%02d/%02d,%02d:%02d:%02d%c%02d"), values[0], values[1], values[2], values[3], values[4], values[5],
+		(timeStamp[6] & 0x08) ? '-' : '+', values[6]);
+}
+
+/*!
+
+	\brief	Convert a service center time stamp into epoch
+
+	\param[in]	timeStamp: raw time stamp (7 semi-octets pairs, as in A6deliver)
+	\return	UTC time as count of seconds since 01/01/1970 (0 if time stamp is invalid)
+
+*/
+uint32_t FF_A6pdu::timeStampToEpoch(const uint8_t* timeStamp) {
+	uint8_t values[7];
+	for (uint8_t i = 0; i < 7; i++) {						// Semi-octets are swapped
+		values[i] = (timeStamp[i] & 0x0f) * 10 + (timeStamp[i] >> 4);
+	}
+	values[6] = (timeStamp[6] & 0x07) * 10 + (timeStamp[6] >> 4);	// Time zone (quarters of hour), without sign bit
+	if (values[1] < 1 || values[1] > 12 || values[2] < 1 || values[2] > 31 || values[3] > 23 || values[4] > 59 || values[5] > 59) {
+		return 0;
+	}
+	uint32_t epoch = FF_A6clock::toEpoch(2000 + values[0], values[1], values[2], values[3], values[4], values[5]);
+	uint32_t offset = values[6] * 900UL;
+	return (timeStamp[6] & 0x08) ? epoch + offset : epoch - offset;	// Local time is UTC plus time zone
+}
+
+/*!
+
+	\brief	Encode a phone number as a destination address field
+
+	Field is the packed form used in PDUs: length in digits, type of address, then digits as swapped semi-octets (padded with 0xF).
+		It takes half the size of the number string, and may be kept to send several messages to same number.
+
+	\param[in]	number: phone number (international numbers start with "+")
+	\param[out]	address: buffer to write address field into (A6_PDU_ADDRESS_LEN octets)
+	\return	Length of encoded field (0 if number is invalid)
+
+*/
+uint8_t FF_A6pdu::encodeNumber(const char* number, uint8_t* address) {
+	return encodeAddress(number, address, false);
+}
+
+/*!
+
+	\brief	Return length of an encoded destination address field
+
+	\param[in]	address: address field, as given by encodeNumber
+	\return	Length of field (0 if field is invalid)
+
+*/
+uint8_t FF_A6pdu::addressLength(const uint8_t* address) {
+	if (!address[0] || address[0] > 20) {
+		return 0;
+	}
+	return (address[0] + 1) / 2 + 2;
+}
+
+/*!
+
+	\brief	Decode an encoded destination address field
+
+	\param[in]	address: address field, as given by encodeNumber
+	\param[out]	number: buffer to write phone number into (A6_PDU_MAX_NUMBER bytes are enough)
+	\param[in]	numberSize: size of number buffer
+	\return	none
+
+*/
+void FF_A6pdu::decodeNumber(const uint8_t* address, char* number, const size_t numberSize) {
+	size_t len = 0;
+	if (!numberSize) return;
+	if (addressLength(address)) {
+		if (address[1] == 0x91 && len < numberSize - 1) {	// International number
+			number[len++] = '+';
+		}
+		for (uint8_t i = 0; i < address[0] && len < numberSize - 1; i++) {
+			uint8_t digit = (i & 1) ? (address[2 + i / 2] >> 4) : (address[2 + i / 2] & 0x0f);
+			number[len++] = '0' + digit;
+		}
+	}
+	number[len] = 0;
+}
+
+/*!
+
+	\brief	[Private] Encode a phone number as semi-octets
+
+	\param[in]	number: phone number (international numbers start with "+")
+	\param[out]	out: buffer to write address field into (at least 12 octets)
+	\param[in]	lengthInOctets: true to give length in octets (SMSC address), false to give it in digits (destination address)
+	\return	Length of encoded field (0 if number is invalid)
+
+*/
+uint8_t FF_A6pdu::encodeAddress(const char* number, uint8_t* out, const bool lengthInOctets) {
+	uint8_t typeOfAddress = 0x81;							// Unknown numbering plan
+	if (*number == '+') {
+		typeOfAddress = 0x91;								// International number
+		number++;
+	}
+	uint8_t digits = 0;
+	for (const char* ptr = number; *ptr; ptr++) {
+		if (*ptr < '0' || *ptr > '9' || digits >= 20) {
+			return 0;
+		}
+		uint8_t digit = *ptr - '0';
+		if (digits & 1) {									// Semi-octets are swapped
+			out[2 + digits / 2] = (out[2 + digits / 2] & 0x0f) | (digit << 4);
+		} else {
+			out[2 + digits / 2] = 0xf0 | digit;
+		}
+		digits++;
+	}
+	if (!digits) {
+		return 0;
+	}
+	uint8_t octets = (digits + 1) / 2;
+	out[0] = lengthInOctets ? octets + 1 : digits;
+	out[1] = typeOfAddress;
+	return octets + 2;
+}
+
+/*!
+
+	\brief	[Private] Append one octet as 2 hex characters to PDU
+
+	\param[in]	value: octet to append
+	\return	none
+
+*/
+void FF_A6pdu::appendHex(const uint8_t value) {
+	static const char hexDigits[] = "0123456789ABCDEF";
+	pduBuffer[pduLength++] = hexDigits[value >> 4];
+	pduBuffer[pduLength++] = hexDigits[value & 0x0f];
+}
+
+/*!
+
+	\brief	[Private] Decode one octet given as 2 hex characters
+
+	\param[in]	hex: hex characters
+	\return	Octet value, or -1 if characters are not hex
+
+*/
+int16_t FF_A6pdu::hexOctet(const char* hex) {
+	int16_t value = 0;
+	for (uint8_t i = 0; i < 2; i++) {
+		char c = hex[i];
+		value <<= 4;
+		if (c >= '0' && c <= '9') {
+			value |= c - '0';
+		} else if (c >= 'A' && c <= 'F') {
+			value |= c - 'A' + 10;
+		} else if (c >= 'a' && c <= 'f') {
+			value |= c - 'a' + 10;
+		} else {
+			return -1;
+		}
+	}
+	return value;
+}
@@ -0,0 +1,111 @@
+/*!
+	\file
+	\brief	SMS-SUBMIT PDU encoder (and SMS-DELIVER decoder) used by FF_A6lib
+	\author	Flying Domotic
+	\date	October 17th, 2026
+
+	Have a look at FF_A6pdu.cpp for details
+
+*/
+
+#ifndef FF_A6pdu_h
+#define FF_A6pdu_h
+
+#include <Arduino.h>
+
+// Constants
+#define A6_PDU_MAX_LEN 400									//!< Max length of an hex encoded PDU (including SMSC field)
+#define A6_PDU_MAX_UD 140									//!< Max length of user data (octets)
+#define A6_PDU_MAX_NUMBER 24								//!< Max length of a decoded phone number (including "+" and final zero)
+#define A6_PDU_ADDRESS_LEN 12								//!< Max length of an encoded address field (length, type of address and 20 semi-octets)
+
+#define A6_DCS_GSM7 0x00									//!< Data coding scheme: GSM-7 default alphabet
+#define A6_DCS_8BIT 0x04									//!< Data coding scheme: 8 bits data
+#define A6_DCS_UCS2 0x08									//!< Data coding scheme: UCS-2 (UTF-16)
+
+#define A6_IEI_CONCAT_8 0x00								//!< Information element: concatenated message, 8 bits reference
+#define A6_IEI_CONCAT_16 0x08								//!< Information element: concatenated message, 16 bits reference
+#define A6_IEI_PORT_8 0x04									//!< Information element: application port addressing, 8 bits ports
+#define A6_IEI_PORT_16 0x05									//!< Information element: application port addressing, 16 bits ports
+#define A6_IEI_SINGLE_SHIFT 0x24							//!< Information element: national language single shift table
+#define A6_IEI_LOCKING_SHIFT 0x25							//!< Information element: national language locking shift table
+
+// Errors (same values as pdulib ones)
+#define A6_PDU_TOO_LONG -3									//!< User data doesn't fit in one PDU
+#define A6_PDU_ADDRESS_FORMAT -5							//!< Bad phone number
+
+/*!
+	\struct A6deliver
+	\brief	Decoded SMS-DELIVER PDU (received message)
+*/
+struct A6deliver {
+	char sender[A6_PDU_MAX_NUMBER];							//!< Sender phone number
+	uint8_t timeStamp[7];									//!< Service center time stamp (raw semi-octets)
+	uint8_t dcs;											//!< Data coding scheme
+	uint8_t udhLen;											//!< Length of user data header (0 if none)
+	uint16_t concatReference;								//!< Concatenated message reference (0 if not multi-part)
+	uint8_t concatCount;									//!< Concatenated message chunk count (0 if not multi-part)
+	uint8_t concatIndex;									//!< Concatenated message chunk index (0 if not multi-part)
+	bool hasPorts;											//!< True if application port addressing is used
+	uint16_t destinationPort;								//!< Destination application port
+	uint16_t sourcePort;									//!< Source application port
+	uint8_t userData[A6_PDU_MAX_UD];						//!< User data after header (packed septets, including header, for GSM-7)
+	uint8_t userDataLen;									//!< Length of user data (octets)
+};
+
+class FF_A6pdu {
+public:
+	/*!	\class FF_A6pdu
+		\brief SMS-SUBMIT PDU encoder used by FF_A6lib
+
+		This class builds hex encoded SMS-SUBMIT PDUs from already encoded user data (GSM-7 septets or octets), with an optional user data header.
+
+		It also decodes SMS-DELIVER PDUs headers, and user data of 8 bits messages (other alphabets being decoded by pdulib).
+	*/
+	FF_A6pdu();
+
+	// Public routines (documented in FF_A6pdu.cpp)
+	bool setScaNumber(const char* number);
+	int encodeSubmit(const char* number, const uint8_t dcs, const uint8_t* udh, const uint8_t udhLen, const uint8_t* userData, const uint8_t userDataLen);
+	int encodeSubmit(const uint8_t* address, const uint8_t dcs, const uint8_t* udh, const uint8_t udhLen, const uint8_t* userData, const uint8_t userDataLen);
+	const char* getPdu(void);
+	static uint8_t encodeNumber(const char* number, uint8_t* address);
+	static uint8_t addressLength(const uint8_t* address);
+	static void decodeNumber(const uint8_t* address, char* number, const size_t numberSize);
+	static uint8_t buildConcatUdh(uint8_t* udh, const uint16_t reference, const uint8_t count, const uint8_t index, const bool reference16 = true);
+	static uint8_t buildShiftUdh(uint8_t* udh, const uint8_t locking, const uint8_t single);
+	static uint8_t buildPortUdh(uint8_t* udh, const uint16_t destinationPort, const uint16_t sourcePort);
+	static bool decodeDeliver(const char* pdu, A6deliver& deliver);
+	static uint8_t dcsAlphabet(const uint8_t dcs);
+	static uint32_t timeStampToEpoch(const uint8_t* timeStamp);
+	static void formatTimeStamp(const uint8_t* timeStamp, char* buffer, const size_t bufferSize);
+
+	/*!
+
+		\brief	Return user data capacity of one PDU
+
+		\param[in]	dcs: data coding scheme (A6_DCS_GSM7, A6_DCS_8BIT or A6_DCS_UCS2)
+		\param[in]	udhLen: length of user data header information elements (0 if none)
+		\return	Capacity in septets (GSM-7), UTF-16 units (UCS-2) or octets (8 bits)
+
+	*/
+	static constexpr uint16_t udCapacity(const uint8_t dcs, const uint8_t udhLen) {
+		uint16_t udhOctets = udhLen ? udhLen + 1 : 0;
+		return ((dcs & 0x0c) == A6_DCS_GSM7) ? ((A6_PDU_MAX_UD - udhOctets) * 8) / 7
+			: ((dcs & 0x0c) == A6_DCS_UCS2) ? (A6_PDU_MAX_UD - udhOctets) / 2
+			: A6_PDU_MAX_UD - udhOctets;
+	}
+
+private:
+	// Private routines (documented in FF_A6pdu.cpp)
+	static uint8_t encodeAddress(const char* number, uint8_t* out, const bool lengthInOctets);
+	static int16_t hexOctet(const char* hex);
+	void appendHex(const uint8_t value);
+
+	// Private variables
+	char pduBuffer[A6_PDU_MAX_LEN];							//!< Hex encoded PDU
+	uint16_t pduLength;										//!< Used length of PDU buffer
+	uint8_t scaField[12];									//!< Encoded SMSC address field (including length)
+	uint8_t scaFieldLen;									//!< Length of encoded SMSC address field
+};
+#endif
@@ -0,0 +1,231 @@
+/*!
+	\file
+	\brief	Modem power control, used by FF_A6lib to recover a hung modem
+	\author	Flying Domotic
+	\date	October 17th, 2026
+*/
+
+#include <FF_A6power.h>
+
+// Class constructor : init some variables
+FF_A6powerDriver::FF_A6powerDriver() {
+	resetPulse = A6_POWER_RESET_PULSE;
+	powerKeyPulse = A6_POWER_KEY_PULSE;
+	powerOffWait = A6_POWER_OFF_WAIT;
+	bootWait = A6_POWER_BOOT_WAIT;
+}
+
+/*!
+
+	\brief	Set pulse timings
+
+	\param[in]	resetPulseMs: reset pulse duration (ms)
+	\param[in]	powerKeyPulseMs: power key pulse duration (ms)
+	\param[in]	powerOffWaitMs: wait after power off, before powering modem on again (ms)
+	\param[in]	bootWaitMs: wait after reset or power on, before first command (ms)
+	\return	none
+
+*/
+void FF_A6powerDriver::setTimings(const uint16_t resetPulseMs, const uint16_t powerKeyPulseMs, const uint16_t powerOffWaitMs, const uint16_t bootWaitMs) {
+	resetPulse = resetPulseMs;
+	powerKeyPulse = powerKeyPulseMs;
+	powerOffWait = powerOffWaitMs;
+	bootWait = bootWaitMs;
+}
+
+// Class constructor : init some variables and set pins inactive
+FF_A6gpioPower::FF_A6gpioPower(const int8_t powerKey, const int8_t reset, const bool high, const int8_t status) {
+	powerKeyPin = powerKey;
+	resetPin = reset;
+	statusPin = status;
+	activeHigh = high;
+	if (statusPin >= 0) {
+		pinMode(statusPin, INPUT);
+	}
+	if (powerKeyPin >= 0) {
+		pinMode(powerKeyPin, OUTPUT);
+		setPowerKey(false);
+	}
+	if (resetPin >= 0) {
+		pinMode(resetPin, OUTPUT);
+		setReset(false);
+	}
+}
+
+/*!
+
+	\brief	Set power key pin state
+
+	\param[in]	active: true to press power key, false to release it
+	\return	none
+
+*/
+void FF_A6gpioPower::setPowerKey(const bool active) {
+	if (powerKeyPin >= 0) digitalWrite(powerKeyPin, (active == activeHigh) ? HIGH : LOW);
+}
+
+/*!
+
+	\brief	Set reset pin state
+
+	\param[in]	active: true to assert reset, false to release it
+	\return	none
+
+*/
+void FF_A6gpioPower::setReset(const bool active) {
+	if (resetPin >= 0) digitalWrite(resetPin, (active == activeHigh) ? HIGH : LOW);
+}
+
+/*!
+
+	\brief	Tell if power key pin is defined
+
+	\param	none
+	\return	true if power key is connected
+
+*/
+bool FF_A6gpioPower::hasPowerKey(void) {
+	return powerKeyPin >= 0;
+}
+
+/*!
+
+	\brief	Tell if reset pin is defined
+
+	\param	none
+	\return	true if reset line is connected
+
+*/
+bool FF_A6gpioPower::hasReset(void) {
+	return resetPin >= 0;
+}
+
+/*!
+
+	\brief	Tell if status pin is defined
+
+	\param	none
+	\return	true if status line is connected
+
+*/
+bool FF_A6gpioPower::hasStatus(void) {
+	return statusPin >= 0;
+}
+
+/*!
+
+	\brief	Read status pin
+
+	\param	none
+	\return	true if modem is powered on
+
+*/
+bool FF_A6gpioPower::isPoweredOn(void) {
+	return statusPin >= 0 && digitalRead(statusPin) == HIGH;
+}
+
+// Class constructor : init some variables
+FF_A6mockPower::FF_A6mockPower(const bool on, const bool withStatus) {
+	powerKeyPulses = 0;
+	resetPulses = 0;
+	poweredOn = on;
+	statusAvailable = withStatus;
+	powerKeyActive = false;
+	resetActive = false;
+	eventCb = NULL;
+}
+
+/*!
+
+	\brief	Set simulated power key state, toggling modem power when key is released
+
+	\param[in]	active: true to press power key, false to release it
+	\return	none
+
+*/
+void FF_A6mockPower::setPowerKey(const bool active) {
+	if (active == powerKeyActive) return;
+	powerKeyActive = active;
+	if (!active) {
+		powerKeyPulses++;
+		poweredOn = !poweredOn;
+	}
+	if (eventCb) (*eventCb)(A6_POWER_LINE_KEY, active);
+}
+
+/*!
+
+	\brief	Set simulated reset line state
+
+	\param[in]	active: true to assert reset, false to release it
+	\return	none
+
+*/
+void FF_A6mockPower::setReset(const bool active) {
+	if (active == resetActive) return;
+	resetActive = active;
+	if (!active) {
+		resetPulses++;
+	}
+	if (eventCb) (*eventCb)(A6_POWER_LINE_RESET, active);
+}
+
+/*!
+
+	\brief	Tell if power key can be driven
+
+	\param	none
+	\return	always true
+
+*/
+bool FF_A6mockPower::hasPowerKey(void) {
+	return true;
+}
+
+/*!
+
+	\brief	Tell if reset line can be driven
+
+	\param	none
+	\return	always true
+
+*/
+bool FF_A6mockPower::hasReset(void) {
+	return true;
+}
+
+/*!
+
+	\brief	Tell if simulated status is given to FF_A6lib
+
+	\param	none
+	\return	true if status is readable, as given to constructor
+
+*/
+bool FF_A6mockPower::hasStatus(void) {
+	return statusAvailable;
+}
+
+/*!
+
+	\brief	Read simulated modem status
+
+	\param	none
+	\return	true if simulated modem is powered on
+
+*/
+bool FF_A6mockPower::isPoweredOn(void) {
+	return poweredOn;
+}
+
+/*!
+
+	\brief	Set callback receiving line changes
+
+	\param[in]	callback: routine called with line (A6_POWER_LINE_KEY or A6_POWER_LINE_RESET) and its new state (NULL to remove)
+	\return	none
+
+*/
+void FF_A6mockPower::setEventCallback(void (*callback)(const uint8_t line, const bool active)) {
+	eventCb = callback;
+}
@@ -0,0 +1,177 @@
+/*!
+	\file
+	\brief	Modem power control, used by FF_A6lib to recover a hung modem
+	\author	Flying Domotic
+	\date	October 17th, 2026
+
+	Have a look at FF_A6power.cpp for details
+
+*/
+
+#ifndef FF_A6power_h
+#define FF_A6power_h
+
+#include <Arduino.h>
+
+// Constants
+#define A6_POWER_RESET_PULSE 200							//!< Default reset pulse duration (ms)
+#define A6_POWER_KEY_PULSE 2500								//!< Default power key pulse duration (ms)
+#define A6_POWER_OFF_WAIT 3000								//!< Default wait after power off (ms)
+#define A6_POWER_BOOT_WAIT 5000								//!< Default wait after reset or power on, before first command (ms)
+#define A6_POWER_LINE_KEY 0									//!< Power key line, as given to mock driver event callback
+#define A6_POWER_LINE_RESET 1								//!< Reset line, as given to mock driver event callback
+
+class FF_A6powerDriver {
+public:
+	/*!	\class FF_A6powerDriver
+		\brief Modem power control interface
+
+		FF_A6lib only drives modem through this interface, using pulse timings given here.
+			FF_A6gpioPower drives real pins. Other implementations may drive a relay, an I/O expander,
+			or simulate modem for tests (see FF_A6mockPower).
+
+		As power key toggles modem power, FF_A6lib needs to know if modem is on before pressing it.
+			Drivers able to read modem status line should implement hasStatus() and isPoweredOn().
+			Else, FF_A6lib sends an AT command after switching modem off, and only switches it on again when it doesn't answer.
+	*/
+	FF_A6powerDriver();
+	virtual ~FF_A6powerDriver() {}
+
+	/*!
+
+		\brief	Set power key state
+
+		\param[in]	active: true to press power key, false to release it
+		\return	none
+
+	*/
+	virtual void setPowerKey(const bool active) = 0;
+
+	/*!
+
+		\brief	Set reset line state
+
+		\param[in]	active: true to assert reset, false to release it
+		\return	none
+
+	*/
+	virtual void setReset(const bool active) = 0;
+
+	/*!
+
+		\brief	Tell if power key can be driven
+
+		\param	none
+		\return	true if power key is connected
+
+	*/
+	virtual bool hasPowerKey(void) = 0;
+
+	/*!
+
+		\brief	Tell if reset line can be driven
+
+		\param	none
+		\return	true if reset line is connected
+
+	*/
+	virtual bool hasReset(void) = 0;
+
+	/*!
+
+		\brief	Tell if modem status can be read
+
+		\param	none
+		\return	true if isPoweredOn() gives modem status
+
+	*/
+	virtual bool hasStatus(void) {return false;}
+
+	/*!
+
+		\brief	Read modem status
+
+		\param	none
+		\return	true if modem is powered on (meaningless if hasStatus() is false)
+
+	*/
+	virtual bool isPoweredOn(void) {return false;}
+
+	// Public routines (documented in FF_A6power.cpp)
+	void setTimings(const uint16_t resetPulseMs, const uint16_t powerKeyPulseMs, const uint16_t powerOffWaitMs, const uint16_t bootWaitMs);
+
+	// Public variables
+	uint16_t resetPulse;									//!< Reset pulse duration (ms)
+	uint16_t powerKeyPulse;									//!< Power key pulse duration (ms)
+	uint16_t powerOffWait;									//!< Wait after power off (ms)
+	uint16_t bootWait;										//!< Wait after reset or power on, before first command (ms)
+};
+
+class FF_A6gpioPower : public FF_A6powerDriver {
+public:
+	/*!	\class FF_A6gpioPower
+		\brief Modem power control through GPIO pins
+
+		\code
+			FF_A6gpioPower power(D5, D6, true, D7);	// Power key on D5, reset on D6, both active high, status on D7
+			a6.setPowerDriver(&power);
+			...
+			if (a6.needRestart()) a6.recover();
+		\endcode
+	*/
+	FF_A6gpioPower(const int8_t powerKeyPin, const int8_t resetPin, const bool activeHigh = true, const int8_t statusPin = -1);
+
+	// Public routines (documented in FF_A6power.cpp)
+	void setPowerKey(const bool active) override;
+	void setReset(const bool active) override;
+	bool hasPowerKey(void) override;
+	bool hasReset(void) override;
+	bool hasStatus(void) override;
+	bool isPoweredOn(void) override;
+
+private:
+	// Private variables
+	int8_t powerKeyPin;										//!< Power key pin (-1 if not connected)
+	int8_t resetPin;										//!< Reset pin (-1 if not connected)
+	int8_t statusPin;										//!< Status pin, high when modem is on (-1 if not connected)
+	bool activeHigh;										//!< True if pins are active high
+};
+
+class FF_A6mockPower : public FF_A6powerDriver {
+public:
+	/*!	\class FF_A6mockPower
+		\brief Simulated modem power control, for tests without hardware
+
+		Records pulses and simulates modem power, toggled by each power key press.
+			An optional callback receives each line change, to drive a modem emulator (for example, stop answering while off).
+
+		\code
+			FF_A6mockPower power(true, false);		// Modem on, status not readable
+			power.setTimings(10, 10, 10, 10);		// Speed test up
+			a6.setPowerDriver(&power);
+		\endcode
+	*/
+	FF_A6mockPower(const bool poweredOn = true, const bool withStatus = false);
+
+	// Public routines (documented in FF_A6power.cpp)
+	void setPowerKey(const bool active) override;
+	void setReset(const bool active) override;
+	bool hasPowerKey(void) override;
+	bool hasReset(void) override;
+	bool hasStatus(void) override;
+	bool isPoweredOn(void) override;
+	void setEventCallback(void (*callback)(const uint8_t line, const bool active));
+
+	// Public variables
+	uint16_t powerKeyPulses;								//!< Count of power key presses
+	uint16_t resetPulses;									//!< Count of reset pulses
+	bool poweredOn;											//!< Simulated modem power
+
+private:
+	// Private variables
+	bool statusAvailable;									//!< True if status is given to FF_A6lib
+	bool powerKeyActive;									//!< Current power key state
+	bool resetActive;										//!< Current reset line state
+	void (*eventCb)(const uint8_t line, const bool active);	//!< Line change callback (NULL if none)
+};
+#endif
@@ -0,0 +1,171 @@
+/*!
+	\file
+	\brief	Keyword router for commands received by SMS
+	\author	Flying Domotic
+	\date	October 17th, 2026
+*/
+
+#include <FF_A6router.h>
+
+// Class constructor : init some variables
+FF_A6router::FF_A6router() {
+	nodes[0] = A6routerNode{0, A6_ROUTER_NONE, A6_ROUTER_NONE, A6_ROUTER_NONE};
+	nodeCount = 1;
+	handlerCount = 0;
+	unknownHandler = NULL;
+}
+
+/*!
+
+	\brief	Register handler of a keyword
+
+	\param[in]	keyword: command keyword (case insensitive, without spaces)
+	\param[in]	handler: routine to call when a message starts with keyword
+	\return	true if handler has been registered, false if keyword is empty or tables are full
+
+*/
+bool FF_A6router::on(const char* keyword, void (*handler)(const A6command& command)) {
+	if (!*keyword || handlerCount >= A6_ROUTER_MAX_HANDLERS) {
+		return false;
+	}
+	uint8_t node = 0;
+	for (const char* ptr = keyword; *ptr; ptr++) {
+		char character = toupper(*ptr);
+		uint8_t child = findChild(node, character);
+		if (child == A6_ROUTER_NONE) {						// Add a new node as first child
+			if (nodeCount >= A6_ROUTER_MAX_NODES) {
+				return false;
+			}
+			child = nodeCount++;
+			nodes[child] = A6routerNode{character, A6_ROUTER_NONE, nodes[node].firstChild, A6_ROUTER_NONE};
+			nodes[node].firstChild = child;
+		}
+		node = child;
+	}
+	if (nodes[node].handler != A6_ROUTER_NONE) {			// Keyword already known, replace handler
+		handlers[nodes[node].handler] = handler;
+		return true;
+	}
+	handlers[handlerCount] = handler;
+	nodes[node].handler = handlerCount++;
+	return true;
+}
+
+/*!
+
+	\brief	Register handler of messages not starting with a known keyword
+
+	\param[in]	handler: routine to call (NULL to ignore unknown messages)
+	\return	none
+
+*/
+void FF_A6router::onUnknown(void (*handler)(const A6command& command)) {
+	unknownHandler = handler;
+}
+
+/*!
+
+	\brief	Give a message to handler of its keyword
+
+	\param[in]	number: sender phone number
+	\param[in]	message: received message
+	\return	true if a handler has been called, false else
+
+*/
+bool FF_A6router::dispatch(const char* number, const char* message) {
+	A6command command;
+	command.number = number;
+	command.message = message;
+	command.count = tokenize(message, command.tokens, A6_ROUTER_MAX_TOKENS);
+	void (*handler)(const A6command& command) = unknownHandler;
+	if (command.count) {
+		uint8_t node = 0;
+		for (uint8_t i = 0; i < command.tokens[0].length && node != A6_ROUTER_NONE; i++) {
+			node = findChild(node, toupper(command.tokens[0].text[i]));
+		}
+		if (node != A6_ROUTER_NONE && nodes[node].handler != A6_ROUTER_NONE) {
+			handler = handlers[nodes[node].handler];
+		}
+	}
+	if (!handler) {
+		return false;
+	}
+	(*handler)(command);
+	return true;
+}
+
+/*!
+
+	\brief	Split a message into tokens separated by spaces
+
+	\param[in]	message: message to split
+	\param[out]	tokens: tokens found
+	\param[in]	maxTokens: max count of tokens (last one contains remaining part of message)
+	\return	Count of tokens found
+
+*/
+uint8_t FF_A6router::tokenize(const char* message, A6token* tokens, const uint8_t maxTokens) {
+	uint8_t count = 0;
+	const char* ptr = message;
+	while (count < maxTokens) {
+		while (*ptr == ' ' || *ptr == '\t') ptr++;
+		if (!*ptr) break;
+		tokens[count].text = ptr;
+		if (count == maxTokens - 1) {						// Last token gets remaining text, without trailing spaces
+			const char* end = ptr + strlen(ptr);
+			while (end > ptr && (end[-1] == ' ' || end[-1] == '\t')) end--;
+			ptr = end;
+		} else {
+			while (*ptr && *ptr != ' ' && *ptr != '\t') ptr++;
+		}
+		tokens[count].length = (ptr - tokens[count].text > 255) ? 255 : ptr - tokens[count].text;
+		count++;
+	}
+	return count;
+}
+
+/*!
+
+	\brief	[Private] Find child of a node holding a character
+
+	\param[in]	parent: parent node
+	\param[in]	character: upper case character
+	\return	Child node (A6_ROUTER_NONE if not found)
+
+*/
+uint8_t FF_A6router::findChild(const uint8_t parent, const char character) {
+	for (uint8_t child = nodes[parent].firstChild; child != A6_ROUTER_NONE; child = nodes[child].nextSibling) {
+		if (nodes[child].character == character) {
+			return child;
+		}
+	}
+	return A6_ROUTER_NONE;
+}
+
+/*!
+
+	\brief	Compare token with a value (case insensitive)
+
+	\param[in]	value: value to compare with
+	\return	true if token equals value
+
+*/
+bool A6token::equals(const char* value) const {
+	return strlen(value) == length && !strncasecmp(text, value, length);
+}
+
+/*!
+
+	\brief	Convert token to a number
+
+	\param	none
+	\return	Token value (0 if token doesn't start with a number)
+
+*/
+long A6token::toLong(void) const {
+	char buffer[12];
+	uint8_t len = (length < sizeof(buffer)) ? length : sizeof(buffer) - 1;
+	memcpy(buffer, text, len);
+	buffer[len] = 0;
+	return strtol(buffer, NULL, 10);
+}
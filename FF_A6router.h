@@ -0,0 +1,95 @@
+/*!
+	\file
+	\brief	Keyword router for commands received by SMS
+	\author	Flying Domotic
+	\date	October 17th, 2026
+
+	Have a look at FF_A6router.cpp for details
+
+*/
+
+#ifndef FF_A6router_h
+#define FF_A6router_h
+
+#include <Arduino.h>
+
+// Constants
+#ifndef A6_ROUTER_MAX_NODES
+	#define A6_ROUTER_MAX_NODES 128							//!< Max count of trie nodes (about one per keyword character)
+#endif
+#define A6_ROUTER_MAX_HANDLERS 16							//!< Max count of keywords
+#define A6_ROUTER_MAX_TOKENS 8								//!< Max count of tokens in a command (including keyword)
+#define A6_ROUTER_NONE 0xff									//!< No node
+
+static_assert(A6_ROUTER_MAX_NODES < A6_ROUTER_NONE, "A6_ROUTER_MAX_NODES must be lower than A6_ROUTER_NONE, as nodes are indexed on 8 bits");
+
+/*!
+	\struct A6token
+	\brief	View over a token of a received message (not zero terminated)
+*/
+struct A6token {
+	const char* text;										//!< Token start in message
+	uint8_t length;											//!< Token length
+
+	bool equals(const char* value) const;
+	long toLong(void) const;
+};
+
+/*!
+	\struct A6command
+	\brief	Tokenized command, first token being keyword
+*/
+struct A6command {
+	const char* number;										//!< Sender phone number
+	const char* message;									//!< Full message
+	uint8_t count;											//!< Count of tokens
+	A6token tokens[A6_ROUTER_MAX_TOKENS];					//!< Tokens (last one contains remaining text if message has more tokens)
+};
+
+/*!
+	\struct A6routerNode
+	\brief	Trie node (one character of a keyword)
+*/
+struct A6routerNode {
+	char character;											//!< Upper case character
+	uint8_t firstChild;										//!< First child node (A6_ROUTER_NONE if none)
+	uint8_t nextSibling;									//!< Next sibling node (A6_ROUTER_NONE if none)
+	uint8_t handler;										//!< Handler index of keyword ending here (A6_ROUTER_NONE if none)
+};
+
+class FF_A6router {
+public:
+	/*!	\class FF_A6router
+		\brief Keyword router for commands received by SMS
+
+		Keywords are stored in a trie, so finding the handler of a command only depends on keyword length, not on count of keywords.
+			Keywords are case insensitive. Arguments are given as views over received message, without copy.
+
+		\code
+			void relayCommand(const A6command& command) {
+				if (command.count == 3 && command.tokens[2].equals("ON")) setRelay(command.tokens[1].toLong(), true);
+			}
+			router.on("RELAY", relayCommand);
+			a6.setRouter(&router);
+		\endcode
+	*/
+	FF_A6router();
+
+	// Public routines (documented in FF_A6router.cpp)
+	bool on(const char* keyword, void (*handler)(const A6command& command));
+	void onUnknown(void (*handler)(const A6command& command));
+	bool dispatch(const char* number, const char* message);
+	static uint8_t tokenize(const char* message, A6token* tokens, const uint8_t maxTokens);
+
+private:
+	// Private routines (documented in FF_A6router.cpp)
+	uint8_t findChild(const uint8_t parent, const char character);
+
+	// Private variables
+	A6routerNode nodes[A6_ROUTER_MAX_NODES];				//!< Trie nodes (first one is root)
+	uint8_t nodeCount;										//!< Count of used nodes
+	void (*handlers[A6_ROUTER_MAX_HANDLERS])(const A6command& command);	//!< Keyword handlers
+	uint8_t handlerCount;									//!< Count of used handlers
+	void (*unknownHandler)(const A6command& command);		//!< Handler of unknown keywords (NULL if none)
+};
+#endif
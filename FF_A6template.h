@@ -0,0 +1,122 @@
+/*!
+	\file
+	\brief	Compile-time message templates for FF_A6lib
+	\author	Flying Domotic
+	\date	October 17th, 2026
+
+	A template is a constant message containing "{}" placeholders, replaced by fields when sending it.
+
+	Static parts are encoded (GSM-7 septets or UTF-16) at compile time, only fields being encoded at run time:
+	\code
+		constexpr FF_A6template alarmTemplate("Alarm {} on sensor {}");
+		a6.sendTemplate(number, alarmTemplate, "HIGH", "garage");
+	\endcode
+
+*/
+
+#ifndef FF_A6template_h
+#define FF_A6template_h
+
+#include <Arduino.h>
+#include <FF_A6text.h>
+
+// Constants
+#define A6_TEMPLATE_MAX_FIELDS 8							//!< Max count of fields in a template
+
+/*!
+	\struct A6templateView
+	\brief	Size independent view of a FF_A6template, as used by FF_A6lib::sendTemplate
+*/
+struct A6templateView {
+	uint8_t dcs;											//!< Data coding scheme of static parts (A6_DCS_GSM7 or A6_DCS_UCS2)
+	uint8_t fieldCount;										//!< Count of fields (placeholders)
+	uint16_t staticLength;									//!< Length of static parts (septets for GSM-7, UTF-16 units for UCS-2)
+	const uint16_t* partOffset;								//!< Offset of each static part in encoded data
+	const uint16_t* partLength;								//!< Length of each static part in encoded data (septets or octets)
+	const uint16_t* textOffset;								//!< Offset of each static part in template text
+	const uint16_t* textLength;								//!< Length of each static part in template text (bytes)
+	const uint8_t* encoded;									//!< Encoded static parts
+	const char* text;										//!< Template text
+};
+
+template <size_t N>
+class FF_A6template {
+public:
+	/*!	\class FF_A6template
+		\brief Compile-time message template for FF_A6lib
+
+		Static parts use default GSM-7 alphabet if they all fit in it, else UCS-2.
+			Fields are encoded at run time using the same alphabet, and message is sent as a single SMS when it fits.
+			Else, full message is rebuilt and sent by FF_A6lib::sendSMS.
+	*/
+
+	/*!
+
+		\brief	Parse and encode a template
+
+		\param[in]	templateText: template text, fields being given as "{}"
+
+	*/
+	constexpr FF_A6template(const char (&templateText)[N]) {
+		uint16_t len = N - 1;
+		for (uint16_t i = 0; i < N; i++) {
+			text[i] = templateText[i];
+		}
+		// Split text on placeholders
+		uint16_t partStart = 0;
+		fieldCount = 0;
+		for (uint16_t i = 0; i < len; i++) {
+			if (i + 1 < len && text[i] == '{' && text[i + 1] == '}' && fieldCount < A6_TEMPLATE_MAX_FIELDS) {
+				textOffset[fieldCount] = partStart;
+				textLength[fieldCount] = i - partStart;
+				fieldCount++;
+				partStart = i + 2;
+				i++;
+			}
+		}
+		textOffset[fieldCount] = partStart;
+		textLength[fieldCount] = len - partStart;
+		// Use GSM-7 default alphabet if all static parts fit in it
+		dcs = A6_DCS_GSM7;
+		for (uint8_t i = 0; i <= fieldCount; i++) {
+			if (textLength[i] && !FF_A6text::gsm7Length(text + textOffset[i], textLength[i], A6_LANG_DEFAULT, A6_LANG_DEFAULT)) {
+				dcs = A6_DCS_UCS2;
+			}
+		}
+		// Encode static parts
+		uint16_t offset = 0;
+		for (uint8_t i = 0; i <= fieldCount; i++) {
+			partOffset[i] = offset;
+			if (dcs == A6_DCS_GSM7) {
+				partLength[i] = FF_A6text::gsm7Encode(text, textOffset[i], textOffset[i] + textLength[i], encoded + offset, sizeof(encoded) - offset, A6_LANG_DEFAULT, A6_LANG_DEFAULT);
+			} else {
+				partLength[i] = FF_A6text::utf16Encode(text, textOffset[i], textOffset[i] + textLength[i], encoded + offset, sizeof(encoded) - offset);
+			}
+			offset += partLength[i];
+		}
+		staticLength = (dcs == A6_DCS_GSM7) ? offset : offset / 2;
+	}
+
+	/*!
+
+		\brief	Return a size independent view of template
+
+		\param	none
+		\return	Template view
+
+	*/
+	constexpr A6templateView view(void) const {
+		return A6templateView{dcs, fieldCount, staticLength, partOffset, partLength, textOffset, textLength, encoded, text};
+	}
+
+	uint8_t dcs = A6_DCS_GSM7;								//!< Data coding scheme of static parts
+	uint8_t fieldCount = 0;									//!< Count of fields
+	uint16_t staticLength = 0;								//!< Length of static parts (septets or UTF-16 units)
+	uint16_t partOffset[A6_TEMPLATE_MAX_FIELDS + 1] = {};	//!< Offset of each static part in encoded data
+	uint16_t partLength[A6_TEMPLATE_MAX_FIELDS + 1] = {};	//!< Length of each static part in encoded data
+	uint16_t textOffset[A6_TEMPLATE_MAX_FIELDS + 1] = {};	//!< Offset of each static part in template text
+	uint16_t textLength[A6_TEMPLATE_MAX_FIELDS + 1] = {};	//!< Length of each static part in template text
+	uint8_t encoded[2 * N] = {};							//!< Encoded static parts (at most 2 septets or octets per UTF-8 byte)
+	char text[N] = {};										//!< Template text
+};
+#endif
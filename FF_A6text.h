@@ -0,0 +1,763 @@
+/*!
+	\file
+	\brief	Text helpers (UTF-8 to UTF-16 and GSM-7 transcoding) used by FF_A6lib to size and encode SMS
+	\author	Flying Domotic
+	\date	October 17th, 2026
+
+	All routines are static and allocation free. Most of them are constexpr, so they can also be used at compile time.
+
+*/
+
+#ifndef FF_A6text_h
+#define FF_A6text_h
+
+#include <Arduino.h>
+#include <FF_A6pdu.h>
+
+// Constants
+#define A6_REPLACEMENT_CHAR 0xFFFD							//!< Unicode code point returned for invalid UTF-8 sequences
+#define A6_GSM7_ESCAPE 0x1b									//!< GSM-7 escape to extension (single shift) table
+#define A6_PLAN_MAX_SEGMENTS 10								//!< Max count of segment ranges stored in a message plan
+
+// National language identifiers (3GPP TS 23.038)
+#define A6_LANG_DEFAULT 0									//!< Default GSM-7 alphabet and extension table
+#define A6_LANG_TURKISH 1									//!< Turkish locking and single shift tables
+#define A6_LANG_SPANISH 2									//!< Spanish single shift table (no locking table)
+#define A6_LANG_PORTUGUESE 3								//!< Portuguese locking and single shift tables
+
+/*!
+	\struct A6transliteration
+	\brief	One entry of transliteration table: an Unicode character and its GSM-7 default alphabet replacement
+
+	Replacement is never longer than UTF-8 coding of character, allowing in place transliteration.
+*/
+struct A6transliteration {
+	uint16_t codePoint;										//!< Unicode code point to replace
+	char replacement[4];									//!< Replacement (default GSM-7 alphabet only)
+};
+
+/*!
+	\struct A6segment
+	\brief	Position of one segment (SMS) in an UTF-8 message
+*/
+struct A6segment {
+	uint16_t start = 0;										//!< Segment start position (bytes)
+	uint16_t end = 0;										//!< Segment end position (bytes, excluded)
+};
+
+/*!
+	\struct A6messagePlan
+	\brief	How a message will be sent: alphabet, count of SMS and position of each of them
+*/
+struct A6messagePlan {
+	uint8_t dcs = A6_DCS_GSM7;								//!< Data coding scheme (A6_DCS_GSM7 or A6_DCS_UCS2)
+	uint8_t lockingShift = A6_LANG_DEFAULT;					//!< GSM-7 locking shift table
+	uint8_t singleShift = A6_LANG_DEFAULT;					//!< GSM-7 single shift table
+	uint16_t length = 0;									//!< Message length (septets for GSM-7, UTF-16 units for UCS-2)
+	uint16_t segmentCapacity = 0;							//!< Capacity of each segment (septets or UTF-16 units)
+	uint16_t segmentCount = 0;								//!< Count of SMS needed
+	uint16_t remaining = 0;									//!< Septets or UTF-16 units still available in last segment
+	A6segment segments[A6_PLAN_MAX_SEGMENTS];				//!< Position of first segments (up to A6_PLAN_MAX_SEGMENTS)
+};
+
+class FF_A6text {
+public:
+	/*!	\class FF_A6text
+		\brief Text helpers (UTF-8 to UTF-16 and GSM-7 transcoding) used by FF_A6lib to size and encode SMS
+
+		UTF-8 characters outside Basic Multilingual Plane (like emoji) are 4 bytes long and need a surrogate pair (2 units) in UTF-16.
+
+		GSM-7 routines work with a locking shift table (replacing default alphabet) and a single shift table (replacing extension table),
+			as defined by 3GPP TS 23.038 national language tables.
+
+		Chunking routines never split an UTF-8 sequence, an UTF-16 surrogate pair nor a GSM-7 escape sequence.
+	*/
+
+	/*!
+
+		\brief	Decode one UTF-8 character
+
+		Invalid or truncated sequences return A6_REPLACEMENT_CHAR and skip one byte only.
+
+		\param[in]	text: UTF-8 message
+		\param[in]	len: message length (bytes)
+		\param[in,out]	pos: position of character to decode, updated to position of next character
+		\return	Unicode code point of decoded character
+
+	*/
+	static constexpr uint32_t utf8Next(const char* text, const uint16_t len, uint16_t& pos) {
+		uint8_t c1 = (uint8_t) text[pos];
+		uint8_t needed = 0;									// Count of continuation bytes
+		uint32_t codePoint = 0;
+		if (c1 < 0x80) {									// One byte (ASCII) character
+			pos++;
+			return c1;
+		} else if (c1 >= 0xc2 && c1 <= 0xdf) {				// Two bytes character
+			needed = 1;
+			codePoint = c1 & 0x1f;
+		} else if (c1 >= 0xe0 && c1 <= 0xef) {				// Three bytes character
+			needed = 2;
+			codePoint = c1 & 0x0f;
+		} else if (c1 >= 0xf0 && c1 <= 0xf4) {				// Four bytes character
+			needed = 3;
+			codePoint = c1 & 0x07;
+		} else {											// Continuation byte or invalid lead byte
+			pos++;
+			return A6_REPLACEMENT_CHAR;
+		}
+		if (pos + needed >= len) {						// Truncated sequence
+			pos++;
+			return A6_REPLACEMENT_CHAR;
+		}
+		for (uint8_t i = 1; i <= needed; i++) {
+			uint8_t c = (uint8_t) text[pos + i];
+			if ((c & 0xc0) != 0x80) {						// Not a continuation byte
+				pos++;
+				return A6_REPLACEMENT_CHAR;
+			}
+			codePoint = (codePoint << 6) | (c & 0x3f);
+		}
+		// Reject overlong sequences, surrogates and out of range values
+		if ((needed == 2 && codePoint < 0x800) || (needed == 3 && (codePoint < 0x10000 || codePoint > 0x10ffff))
+				|| (codePoint >= 0xd800 && codePoint <= 0xdfff)) {
+			pos++;
+			return A6_REPLACEMENT_CHAR;
+		}
+		pos += needed + 1;
+		return codePoint;
+	}
+
+	/*!
+
+		\brief	Return number of UTF-16 units needed to code one Unicode character
+
+		\param[in]	codePoint: Unicode code point
+		\return	1 for Basic Multilingual Plane characters, 2 (surrogate pair) else
+
+	*/
+	static constexpr uint8_t utf16Units(const uint32_t codePoint) {
+		return (codePoint >= 0x10000) ? 2 : 1;
+	}
+
+	/*!
+
+		\brief	Return UTF-16 length (in units) of an UTF-8 message
+
+		Bytes are scanned 4 at a time: each non continuation byte gives one unit, and each 4 bytes lead byte gives one more (surrogate pair).
+
+		\param[in]	text: UTF-8 message
+		\param[in]	len: message length (bytes)
+		\return	Count of UTF-16 units needed to code message
+
+	*/
+	static uint16_t utf16Length(const char* text, const uint16_t len) {
+		uint16_t units = 0;
+		uint16_t i = 0;
+		for (; i + 4 <= len; i += 4) {
+			uint32_t word;
+			memcpy(&word, text + i, sizeof(word));			// Load 4 bytes (alignment safe)
+			if (!(word & 0x80808080UL)) {					// Pure ASCII word, most common case
+				units += 4;
+				continue;
+			}
+			// Bit 7 set and bit 6 clear: continuation byte
+			uint32_t continuation = word & ~(word << 1) & 0x80808080UL;
+			// Bits 7 to 4 set: lead byte of a 4 bytes sequence
+			uint32_t fourBytes = word & (word << 1) & (word << 2) & (word << 3) & 0x80808080UL;
+			units += 4 - __builtin_popcount(continuation) + __builtin_popcount(fourBytes);
+		}
+		for (; i < len; i++) {								// Remaining bytes
+			uint8_t c = (uint8_t) text[i];
+			units += ((c & 0xc0) != 0x80) + (c >= 0xf0);
+		}
+		return units;
+	}
+
+	/*!
+
+		\brief	Return end of an UTF-16 chunk
+
+		Looks for the longest part of message starting at a given position which fits in a given count of UTF-16 units.
+
+		\param[in]	text: UTF-8 message
+		\param[in]	len: message length (bytes)
+		\param[in]	start: chunk start position (bytes)
+		\param[in]	maxUnits: maximum count of UTF-16 units in chunk
+		\return	Chunk end position (bytes, excluded)
+
+	*/
+	static constexpr uint16_t utf16ChunkEnd(const char* text, const uint16_t len, const uint16_t start, const uint16_t maxUnits) {
+		uint16_t pos = start;
+		uint16_t units = 0;
+		while (pos < len) {
+			uint16_t next = pos;
+			uint8_t charUnits = utf16Units(utf8Next(text, len, next));
+			if (units + charUnits > maxUnits) {				// Character (or surrogate pair) doesn't fit
+				break;
+			}
+			units += charUnits;
+			pos = next;
+		}
+		return pos;
+	}
+
+	/*!
+
+		\brief	Encode part of an UTF-8 message into UTF-16 (big endian, as used in SMS)
+
+		\param[in]	text: UTF-8 message
+		\param[in]	start: start position (bytes)
+		\param[in]	end: end position (bytes, excluded)
+		\param[out]	out: buffer to write UTF-16 octets into
+		\param[in]	outSize: size of output buffer (octets)
+		\return	Count of octets written (0 if buffer is too small)
+
+	*/
+	static constexpr uint16_t utf16Encode(const char* text, const uint16_t start, const uint16_t end, uint8_t* out, const uint16_t outSize) {
+		uint16_t pos = start;
+		uint16_t outLen = 0;
+		while (pos < end) {
+			uint32_t codePoint = utf8Next(text, end, pos);
+			if (codePoint >= 0x10000) {						// Needs a surrogate pair
+				if (outLen + 4 > outSize) return 0;
+				codePoint -= 0x10000;
+				uint16_t high = 0xd800 | (codePoint >> 10);
+				uint16_t low = 0xdc00 | (codePoint & 0x3ff);
+				out[outLen++] = high >> 8;
+				out[outLen++] = high & 0xff;
+				out[outLen++] = low >> 8;
+				out[outLen++] = low & 0xff;
+			} else {
+				if (outLen + 2 > outSize) return 0;
+				out[outLen++] = codePoint >> 8;
+				out[outLen++] = codePoint & 0xff;
+			}
+		}
+		return outLen;
+	}
+
+	/*!
+
+		\brief	Return GSM-7 code of one Unicode character in a locking shift table
+
+		\param[in]	codePoint: Unicode code point
+		\param[in]	language: locking shift table (A6_LANG_DEFAULT, A6_LANG_TURKISH or A6_LANG_PORTUGUESE)
+		\return	GSM-7 code (0 to 0x7f), or -1 if character is not in table
+
+	*/
+	static constexpr int16_t gsm7Code(const uint32_t codePoint, const uint8_t language) {
+		if (language == A6_LANG_TURKISH) {
+			switch (codePoint) {
+				case 0x20ac: return 0x04;					// Euro sign
+				case 0x0131: return 0x07;					// Small letter dotless i
+				case 0x011e: return 0x0b;					// Capital letter G with breve
+				case 0x011f: return 0x0c;					// Small letter g with breve
+				case 0x015e: return 0x1c;					// Capital letter S with cedilla
+				case 0x015f: return 0x1d;					// Small letter s with cedilla
+				case 0x0130: return 0x40;					// Capital letter I with dot above
+				case 0x00e7: return 0x60;					// Small letter c with cedilla
+				// Default alphabet characters replaced in Turkish table
+				case 0x00e8: case 0x00ec: case 0x00d8: case 0x00f8: case 0x00c6: case 0x00e6: case 0x00a1: case 0x00bf:
+					return -1;
+			}
+		} else if (language == A6_LANG_PORTUGUESE) {
+			switch (codePoint) {
+				case 0x00ea: return 0x04;					// Small letter e with circumflex
+				case 0x00fa: return 0x06;					// Small letter u with acute
+				case 0x00ed: return 0x07;					// Small letter i with acute
+				case 0x00f3: return 0x08;					// Small letter o with acute
+				case 0x00e7: return 0x09;					// Small letter c with cedilla
+				case 0x00d4: return 0x0b;					// Capital letter O with circumflex
+				case 0x00f4: return 0x0c;					// Small letter o with circumflex
+				case 0x00c1: return 0x0e;					// Capital letter A with acute
+				case 0x00e1: return 0x0f;					// Small letter a with acute
+				case 0x00aa: return 0x12;					// Feminine ordinal indicator
+				case 0x00c7: return 0x13;					// Capital letter C with cedilla
+				case 0x00c0: return 0x14;					// Capital letter A with grave
+				case 0x221e: return 0x15;					// Infinity
+				case 0x005e: return 0x16;					// Circumflex accent
+				case 0x005c: return 0x17;					// Reverse solidus
+				case 0x20ac: return 0x18;					// Euro sign
+				case 0x00d3: return 0x19;					// Capital letter O with acute
+				case 0x007c: return 0x1a;					// Vertical line
+				case 0x00c2: return 0x1c;					// Capital letter A with circumflex
+				case 0x00e2: return 0x1d;					// Small letter a with circumflex
+				case 0x00ca: return 0x1e;					// Capital letter E with circumflex
+				case 0x00ba: return 0x24;					// Masculine ordinal indicator
+				case 0x00cd: return 0x40;					// Capital letter I with acute
+				case 0x00c3: return 0x5b;					// Capital letter A with tilde
+				case 0x00d5: return 0x5c;					// Capital letter O with tilde
+				case 0x00da: return 0x5d;					// Capital letter U with acute
+				case 0x007e: return 0x60;					// Tilde
+				case 0x00e3: return 0x7b;					// Small letter a with tilde
+				case 0x00f5: return 0x7c;					// Small letter o with tilde
+				case 0x0060: return 0x7d;					// Grave accent
+				// Default alphabet characters replaced in Portuguese table
+				case 0x00e8: case 0x00f9: case 0x00ec: case 0x00f2: case 0x00d8: case 0x00f8: case 0x00c5: case 0x00e5:
+				case 0x03a6: case 0x0393: case 0x039b: case 0x03a9: case 0x03a0: case 0x03a8: case 0x03a3: case 0x0398:
+				case 0x039e: case 0x00c6: case 0x00e6: case 0x00df: case 0x00a4: case 0x00a1: case 0x00c4: case 0x00d6:
+				case 0x00d1: case 0x00bf: case 0x00e4: case 0x00f6: case 0x00f1:
+					return -1;
+			}
+		}
+		// Default alphabet
+		if ((codePoint >= 0x20 && codePoint <= 0x23) || (codePoint >= 0x25 && codePoint <= 0x3f)
+				|| (codePoint >= 0x41 && codePoint <= 0x5a) || (codePoint >= 0x61 && codePoint <= 0x7a)) {
+			return codePoint;								// Same code as ASCII
+		}
+		switch (codePoint) {
+			case 0x0040: return 0x00;						// Commercial at
+			case 0x00a3: return 0x01;						// Pound sign
+			case 0x0024: return 0x02;						// Dollar sign
+			case 0x00a5: return 0x03;						// Yen sign
+			case 0x00e8: return 0x04;						// Small letter e with grave
+			case 0x00e9: return 0x05;						// Small letter e with acute
+			case 0x00f9: return 0x06;						// Small letter u with grave
+			case 0x00ec: return 0x07;						// Small letter i with grave
+			case 0x00f2: return 0x08;						// Small letter o with grave
+			case 0x00c7: return 0x09;						// Capital letter C with cedilla
+			case 0x000a: return 0x0a;						// Line feed
+			case 0x00d8: return 0x0b;						// Capital letter O with stroke
+			case 0x00f8: return 0x0c;						// Small letter o with stroke
+			case 0x000d: return 0x0d;						// Carriage return
+			case 0x00c5: return 0x0e;						// Capital letter A with ring
+			case 0x00e5: return 0x0f;						// Small letter a with ring
+			case 0x0394: return 0x10;						// Greek capital letter delta
+			case 0x005f: return 0x11;						// Low line
+			case 0x03a6: return 0x12;						// Greek capital letter phi
+			case 0x0393: return 0x13;						// Greek capital letter gamma
+			case 0x039b: return 0x14;						// Greek capital letter lambda
+			case 0x03a9: return 0x15;						// Greek capital letter omega
+			case 0x03a0: return 0x16;						// Greek capital letter pi
+			case 0x03a8: return 0x17;						// Greek capital letter psi
+			case 0x03a3: return 0x18;						// Greek capital letter sigma
+			case 0x0398: return 0x19;						// Greek capital letter theta
+			case 0x039e: return 0x1a;						// Greek capital letter xi
+			case 0x00c6: return 0x1c;						// Capital letter AE
+			case 0x00e6: return 0x1d;						// Small letter ae
+			case 0x00df: return 0x1e;						// Small letter sharp s
+			case 0x00c9: return 0x1f;						// Capital letter E with acute
+			case 0x00a4: return 0x24;						// Currency sign
+			case 0x00a1: return 0x40;						// Inverted exclamation mark
+			case 0x00c4: return 0x5b;						// Capital letter A with diaeresis
+			case 0x00d6: return 0x5c;						// Capital letter O with diaeresis
+			case 0x00d1: return 0x5d;						// Capital letter N with tilde
+			case 0x00dc: return 0x5e;						// Capital letter U with diaeresis
+			case 0x00a7: return 0x5f;						// Section sign
+			case 0x00bf: return 0x60;						// Inverted question mark
+			case 0x00e4: return 0x7b;						// Small letter a with diaeresis
+			case 0x00f6: return 0x7c;						// Small letter o with diaeresis
+			case 0x00f1: return 0x7d;						// Small letter n with tilde
+			case 0x00fc: return 0x7e;						// Small letter u with diaeresis
+			case 0x00e0: return 0x7f;						// Small letter a with grave
+		}
+		return -1;
+	}
+
+	/*!
+
+		\brief	Return GSM-7 code of one Unicode character in a single shift (extension) table
+
+		\param[in]	codePoint: Unicode code point
+		\param[in]	language: single shift table (A6_LANG_DEFAULT, A6_LANG_TURKISH, A6_LANG_SPANISH or A6_LANG_PORTUGUESE)
+		\return	GSM-7 code to put after escape (0 to 0x7f), or -1 if character is not in table
+
+	*/
+	static constexpr int16_t gsm7ExtensionCode(const uint32_t codePoint, const uint8_t language) {
+		if (language == A6_LANG_TURKISH) {
+			switch (codePoint) {
+				case 0x011e: return 0x47;					// Capital letter G with breve
+				case 0x0130: return 0x49;					// Capital letter I with dot above
+				case 0x015e: return 0x53;					// Capital letter S with cedilla
+				case 0x00e7: return 0x63;					// Small letter c with cedilla
+				case 0x011f: return 0x67;					// Small letter g with breve
+				case 0x0131: return 0x69;					// Small letter dotless i
+				case 0x015f: return 0x73;					// Small letter s with cedilla
+			}
+		} else if (language == A6_LANG_SPANISH) {
+			switch (codePoint) {
+				case 0x00e7: return 0x09;					// Small letter c with cedilla
+				case 0x00c1: return 0x41;					// Capital letter A with acute
+				case 0x00cd: return 0x49;					// Capital letter I with acute
+				case 0x00d3: return 0x4f;					// Capital letter O with acute
+				case 0x00da: return 0x55;					// Capital letter U with acute
+				case 0x00e1: return 0x61;					// Small letter a with acute
+				case 0x00ed: return 0x69;					// Small letter i with acute
+				case 0x00f3: return 0x6f;					// Small letter o with acute
+				case 0x00fa: return 0x75;					// Small letter u with acute
+			}
+		} else if (language == A6_LANG_PORTUGUESE) {
+			switch (codePoint) {
+				case 0x00ea: return 0x05;					// Small letter e with circumflex
+				case 0x00e7: return 0x09;					// Small letter c with cedilla
+				case 0x00d4: return 0x0b;					// Capital letter O with circumflex
+				case 0x00f4: return 0x0c;					// Small letter o with circumflex
+				case 0x00c1: return 0x0e;					// Capital letter A with acute
+				case 0x00e1: return 0x0f;					// Small letter a with acute
+				case 0x03a6: return 0x12;					// Greek capital letter phi
+				case 0x0393: return 0x13;					// Greek capital letter gamma
+				case 0x03a9: return 0x15;					// Greek capital letter omega
+				case 0x03a0: return 0x16;					// Greek capital letter pi
+				case 0x03a8: return 0x17;					// Greek capital letter psi
+				case 0x03a3: return 0x18;					// Greek capital letter sigma
+				case 0x0398: return 0x19;					// Greek capital letter theta
+				case 0x00ca: return 0x1f;					// Capital letter E with circumflex
+				case 0x00c0: return 0x41;					// Capital letter A with grave
+				case 0x00cd: return 0x49;					// Capital letter I with acute
+				case 0x00d3: return 0x4f;					// Capital letter O with acute
+				case 0x00da: return 0x55;					// Capital letter U with acute
+				case 0x00c3: return 0x5b;					// Capital letter A with tilde
+				case 0x00d5: return 0x5c;					// Capital letter O with tilde
+				case 0x00c2: return 0x61;					// Capital letter A with circumflex
+				case 0x00ed: return 0x69;					// Small letter i with acute
+				case 0x00f3: return 0x6f;					// Small letter o with acute
+				case 0x00fa: return 0x75;					// Small letter u with acute
+				case 0x00e3: return 0x7b;					// Small letter a with tilde
+				case 0x00f5: return 0x7c;					// Small letter o with tilde
+				case 0x00e2: return 0x7f;					// Small letter a with circumflex
+			}
+		}
+		// Common part of all extension tables
+		switch (codePoint) {
+			case 0x000c: return 0x0a;						// Form feed
+			case 0x005e: return 0x14;						// Circumflex accent
+			case 0x007b: return 0x28;						// Left curly bracket
+			case 0x007d: return 0x29;						// Right curly bracket
+			case 0x005c: return 0x2f;						// Reverse solidus
+			case 0x005b: return 0x3c;						// Left square bracket
+			case 0x007e: return 0x3d;						// Tilde
+			case 0x005d: return 0x3e;						// Right square bracket
+			case 0x007c: return 0x40;						// Vertical line
+			case 0x20ac: return 0x65;						// Euro sign
+		}
+		return -1;
+	}
+
+	/*!
+
+		\brief	Return number of GSM-7 septets needed to code one Unicode character
+
+		\param[in]	codePoint: Unicode code point
+		\param[in]	locking: locking shift table
+		\param[in]	single: single shift table
+		\return	1 (locking shift table), 2 (escape + single shift table) or 0 if character can't be coded in GSM-7
+
+	*/
+	static constexpr uint8_t gsm7Septets(const uint32_t codePoint, const uint8_t locking, const uint8_t single) {
+		if (gsm7Code(codePoint, locking) >= 0) return 1;
+		if (gsm7ExtensionCode(codePoint, single) >= 0) return 2;
+		return 0;
+	}
+
+	/*!
+
+		\brief	Return GSM-7 length (in septets) of an UTF-8 message
+
+		\param[in]	text: UTF-8 message
+		\param[in]	len: message length (bytes)
+		\param[in]	locking: locking shift table
+		\param[in]	single: single shift table
+		\return	Count of septets needed to code message, or 0 if message can't be coded in GSM-7 with these tables
+
+	*/
+	static constexpr uint16_t gsm7Length(const char* text, const uint16_t len, const uint8_t locking, const uint8_t single) {
+		uint16_t pos = 0;
+		uint16_t septets = 0;
+		while (pos < len) {
+			uint8_t charSeptets = gsm7Septets(utf8Next(text, len, pos), locking, single);
+			if (!charSeptets) return 0;
+			septets += charSeptets;
+		}
+		return septets;
+	}
+
+	/*!
+
+		\brief	Return end of a GSM-7 chunk
+
+		Looks for the longest part of message starting at a given position which fits in a given count of septets.
+
+		\param[in]	text: UTF-8 message
+		\param[in]	len: message length (bytes)
+		\param[in]	start: chunk start position (bytes)
+		\param[in]	maxSeptets: maximum count of septets in chunk
+		\param[in]	locking: locking shift table
+		\param[in]	single: single shift table
+		\return	Chunk end position (bytes, excluded)
+
+	*/
+	static constexpr uint16_t gsm7ChunkEnd(const char* text, const uint16_t len, const uint16_t start, const uint16_t maxSeptets, const uint8_t locking, const uint8_t single) {
+		uint16_t pos = start;
+		uint16_t septets = 0;
+		while (pos < len) {
+			uint16_t next = pos;
+			uint8_t charSeptets = gsm7Septets(utf8Next(text, len, next), locking, single);
+			if (!charSeptets || septets + charSeptets > maxSeptets) {	// Character (or escape sequence) doesn't fit
+				break;
+			}
+			septets += charSeptets;
+			pos = next;
+		}
+		return pos;
+	}
+
+	/*!
+
+		\brief	Encode part of an UTF-8 message into GSM-7 septets (one per byte, not packed)
+
+		\param[in]	text: UTF-8 message
+		\param[in]	start: start position (bytes)
+		\param[in]	end: end position (bytes, excluded)
+		\param[out]	out: buffer to write septets into
+		\param[in]	outSize: size of output buffer (septets)
+		\param[in]	locking: locking shift table
+		\param[in]	single: single shift table
+		\return	Count of septets written (0 if buffer is too small or a character can't be coded)
+
+	*/
+	static constexpr uint16_t gsm7Encode(const char* text, const uint16_t start, const uint16_t end, uint8_t* out, const uint16_t outSize, const uint8_t locking, const uint8_t single) {
+		uint16_t pos = start;
+		uint16_t outLen = 0;
+		while (pos < end) {
+			uint32_t codePoint = utf8Next(text, end, pos);
+			int16_t code = gsm7Code(codePoint, locking);
+			if (code >= 0) {
+				if (outLen + 1 > outSize) return 0;
+				out[outLen++] = code;
+				continue;
+			}
+			code = gsm7ExtensionCode(codePoint, single);
+			if (code < 0 || outLen + 2 > outSize) return 0;
+			out[outLen++] = A6_GSM7_ESCAPE;
+			out[outLen++] = code;
+		}
+		return outLen;
+	}
+	/*!
+
+		\brief	Return length of user data header needed to select national language tables
+
+		\param[in]	locking: locking shift table
+		\param[in]	single: single shift table
+		\return	Length of shift information elements (octets)
+
+	*/
+	static constexpr uint8_t gsm7ShiftUdhLen(const uint8_t locking, const uint8_t single) {
+		return (locking ? 3 : 0) + (single ? 3 : 0);
+	}
+
+	/*!
+
+		\brief	Return count of SMS needed to send an UTF-8 message in GSM-7 with given tables
+
+		\param[in]	text: UTF-8 message
+		\param[in]	len: message length (bytes)
+		\param[in]	locking: locking shift table
+		\param[in]	single: single shift table
+		\param[in]	concatUdhLen: length of concatenation information element used for multi-part messages
+		\return	Count of SMS, or 0 if message can't be coded in GSM-7 with these tables
+
+	*/
+	static constexpr uint16_t gsm7Segments(const char* text, const uint16_t len, const uint8_t locking, const uint8_t single, const uint8_t concatUdhLen) {
+		uint16_t septets = gsm7Length(text, len, locking, single);
+		if (!septets && len) return 0;
+		uint8_t shiftLen = gsm7ShiftUdhLen(locking, single);
+		if (septets <= FF_A6pdu::udCapacity(A6_DCS_GSM7, shiftLen)) return 1;
+		uint16_t capacity = FF_A6pdu::udCapacity(A6_DCS_GSM7, concatUdhLen + shiftLen);
+		uint16_t segments = 0;
+		for (uint16_t pos = 0; pos < len; segments++) {
+			pos = gsm7ChunkEnd(text, len, pos, capacity, locking, single);
+		}
+		return segments;
+	}
+
+	/*!
+
+		\brief	Choose national language tables giving the lowest count of SMS
+
+		Default alphabet is used when message fits in it (national tables only add header overhead).
+			Else, all supported locking/single shift combinations are tried, keeping the first one giving the lowest count of SMS.
+
+		\param[in]	text: UTF-8 message
+		\param[in]	len: message length (bytes)
+		\param[in]	concatUdhLen: length of concatenation information element used for multi-part messages
+		\param[out]	locking: chosen locking shift table
+		\param[out]	single: chosen single shift table
+		\return	Count of SMS, or 0 if message can't be coded in GSM-7 with any table combination
+
+	*/
+	static constexpr uint16_t gsm7ChooseTables(const char* text, const uint16_t len, const uint8_t concatUdhLen, uint8_t& locking, uint8_t& single) {
+		const uint8_t candidates[][2] = {
+			{A6_LANG_DEFAULT, A6_LANG_DEFAULT},
+			{A6_LANG_DEFAULT, A6_LANG_SPANISH},
+			{A6_LANG_DEFAULT, A6_LANG_PORTUGUESE},
+			{A6_LANG_DEFAULT, A6_LANG_TURKISH},
+			{A6_LANG_PORTUGUESE, A6_LANG_DEFAULT},
+			{A6_LANG_TURKISH, A6_LANG_DEFAULT},
+			{A6_LANG_PORTUGUESE, A6_LANG_PORTUGUESE},
+			{A6_LANG_TURKISH, A6_LANG_TURKISH}
+		};
+		uint16_t bestSegments = 0;
+		locking = A6_LANG_DEFAULT;
+		single = A6_LANG_DEFAULT;
+		for (uint8_t i = 0; i < sizeof(candidates) / sizeof(candidates[0]); i++) {
+			uint16_t segments = gsm7Segments(text, len, candidates[i][0], candidates[i][1], concatUdhLen);
+			if (segments && (!bestSegments || segments < bestSegments)) {
+				bestSegments = segments;
+				locking = candidates[i][0];
+				single = candidates[i][1];
+				if (!i) break;								// Default alphabet is enough
+			}
+		}
+		return bestSegments;
+	}
+	//!	Transliteration table, sorted by code point
+	static constexpr A6transliteration transliterationTable[] = {
+		{0x0060, "'"},   {0x00a0, " "},   {0x00ab, "\""},  {0x00bb, "\""},  {0x00c0, "A"},   {0x00c1, "A"},
+		{0x00c2, "A"},   {0x00c3, "A"},   {0x00c8, "E"},   {0x00ca, "E"},   {0x00cb, "E"},   {0x00cc, "I"},
+		{0x00cd, "I"},   {0x00ce, "I"},   {0x00cf, "I"},   {0x00d2, "O"},   {0x00d3, "O"},   {0x00d4, "O"},
+		{0x00d5, "O"},   {0x00d7, "x"},   {0x00d9, "U"},   {0x00da, "U"},   {0x00db, "U"},   {0x00dd, "Y"},
+		{0x00e1, "a"},   {0x00e2, "a"},   {0x00e3, "a"},   {0x00e7, "c"},   {0x00ea, "e"},   {0x00eb, "e"},
+		{0x00ed, "i"},   {0x00ee, "i"},   {0x00ef, "i"},   {0x00f3, "o"},   {0x00f4, "o"},   {0x00f5, "o"},
+		{0x00f7, "/"},   {0x00fa, "u"},   {0x00fb, "u"},   {0x00fd, "y"},   {0x00ff, "y"},   {0x010c, "C"},
+		{0x010d, "c"},   {0x0118, "E"},   {0x0119, "e"},   {0x011e, "G"},   {0x011f, "g"},   {0x0130, "I"},
+		{0x0131, "i"},   {0x0141, "L"},   {0x0142, "l"},   {0x0152, "OE"},  {0x0153, "oe"},  {0x015e, "S"},
+		{0x015f, "s"},   {0x0160, "S"},   {0x0161, "s"},   {0x017d, "Z"},   {0x017e, "z"},   {0x2010, "-"},
+		{0x2011, "-"},   {0x2013, "-"},   {0x2014, "-"},   {0x2018, "'"},   {0x2019, "'"},   {0x201a, "'"},
+		{0x201c, "\""},  {0x201d, "\""},  {0x201e, "\""},  {0x2022, "*"},   {0x2026, "..."}, {0x2039, "'"},
+		{0x203a, "'"},   {0x2122, "TM"},  {0x2212, "-"}
+	};
+
+	/*!
+
+		\brief	Return GSM-7 replacement of one Unicode character
+
+		\param[in]	codePoint: Unicode code point
+		\return	Replacement (default GSM-7 alphabet only), or NULL if character has no replacement
+
+	*/
+	static constexpr const char* transliteration(const uint32_t codePoint) {
+		uint8_t low = 0;
+		uint8_t high = sizeof(transliterationTable) / sizeof(transliterationTable[0]);
+		while (low < high) {								// Binary search
+			uint8_t middle = (low + high) / 2;
+			if (transliterationTable[middle].codePoint == codePoint) {
+				return transliterationTable[middle].replacement;
+			}
+			if (transliterationTable[middle].codePoint < codePoint) {
+				low = middle + 1;
+			} else {
+				high = middle;
+			}
+		}
+		return NULL;
+	}
+
+	/*!
+
+		\brief	Transliterate (in place) characters outside default GSM-7 alphabet and extension table
+
+		Characters already in default GSM-7 alphabet or extension table are kept, others are replaced if they are in transliteration table.
+			This is lossy (accents or typographic quotes are lost), but often keeps message in GSM-7.
+
+		\param[in,out]	text: UTF-8 message (result is never longer than original)
+		\param[in]	len: message length (bytes)
+		\param[out]	replaced: count of replaced characters
+		\return	New message length (bytes), message is zero terminated
+
+	*/
+	static constexpr uint16_t transliterate(char* text, const uint16_t len, uint16_t& replaced) {
+		uint16_t readPos = 0;
+		uint16_t writePos = 0;
+		replaced = 0;
+		while (readPos < len) {
+			uint16_t charStart = readPos;
+			uint32_t codePoint = utf8Next(text, len, readPos);
+			const char* replacement = gsm7Septets(codePoint, A6_LANG_DEFAULT, A6_LANG_DEFAULT) ? NULL : transliteration(codePoint);
+			if (replacement) {
+				replaced++;
+				while (*replacement) {
+					text[writePos++] = *replacement++;
+				}
+			} else {
+				while (charStart < readPos) {				// Keep original character
+					text[writePos++] = text[charStart++];
+				}
+			}
+		}
+		text[writePos] = 0;
+		return writePos;
+	}
+	/*!
+
+		\brief	Plan how an UTF-8 message will be sent
+
+		Selects alphabet as sendSMS does (GSM-7 with best national language tables, else UCS-2), then computes count of SMS,
+			position of each of them (only first A6_PLAN_MAX_SEGMENTS are stored) and space left in last one.
+			Nothing is allocated, and plan can be computed at compile time for constant messages.
+
+		\param[in]	text: UTF-8 message
+		\param[in]	len: message length (bytes)
+		\param[in]	concatUdhLen: length of concatenation information element used for multi-part messages
+		\return	Message plan
+
+	*/
+	static constexpr A6messagePlan planMessage(const char* text, const uint16_t len, const uint8_t concatUdhLen) {
+		A6messagePlan plan;
+		uint16_t lastStart = 0;
+		uint16_t segments = gsm7ChooseTables(text, len, concatUdhLen, plan.lockingShift, plan.singleShift);
+		if (segments) {										// GSM-7 message
+			uint8_t shiftLen = gsm7ShiftUdhLen(plan.lockingShift, plan.singleShift);
+			plan.dcs = A6_DCS_GSM7;
+			plan.length = gsm7Length(text, len, plan.lockingShift, plan.singleShift);
+			plan.segmentCapacity = FF_A6pdu::udCapacity(A6_DCS_GSM7, (segments > 1) ? concatUdhLen + shiftLen : shiftLen);
+		} else {											// UCS-2 message
+			plan.dcs = A6_DCS_UCS2;
+			plan.length = 0;
+			for (uint16_t pos = 0; pos < len;) {
+				plan.length += utf16Units(utf8Next(text, len, pos));
+			}
+			plan.segmentCapacity = FF_A6pdu::udCapacity(A6_DCS_UCS2, (plan.length > FF_A6pdu::udCapacity(A6_DCS_UCS2, 0)) ? concatUdhLen : 0);
+		}
+		// Split message in segments
+		plan.segmentCount = 0;
+		uint16_t pos = 0;
+		do {
+			lastStart = pos;
+			if (plan.dcs == A6_DCS_GSM7) {
+				pos = gsm7ChunkEnd(text, len, pos, plan.segmentCapacity, plan.lockingShift, plan.singleShift);
+			} else {
+				pos = utf16ChunkEnd(text, len, pos, plan.segmentCapacity);
+			}
+			if (plan.segmentCount < A6_PLAN_MAX_SEGMENTS) {
+				plan.segments[plan.segmentCount].start = lastStart;
+				plan.segments[plan.segmentCount].end = pos;
+			}
+			plan.segmentCount++;
+		} while (pos < len && pos > lastStart);
+		// Compute space left in last segment
+		uint16_t used = 0;
+		for (uint16_t i = lastStart; i < pos;) {
+			uint32_t codePoint = utf8Next(text, pos, i);
+			used += (plan.dcs == A6_DCS_GSM7) ? gsm7Septets(codePoint, plan.lockingShift, plan.singleShift) : utf16Units(codePoint);
+		}
+		plan.remaining = plan.segmentCapacity - used;
+		return plan;
+	}
+
+	/*!
+
+		\brief	Plan how a zero terminated UTF-8 message will be sent
+
+		\param[in]	text: UTF-8 message
+		\param[in]	concatUdhLen: length of concatenation information element used for multi-part messages
+		\return	Message plan
+
+	*/
+	static constexpr A6messagePlan planMessage(const char* text, const uint8_t concatUdhLen = 6) {
+		uint16_t len = 0;
+		while (text[len]) len++;
+		return planMessage(text, len, concatUdhLen);
+	}
+};
+#endif